@@ -0,0 +1,310 @@
+/// @file nodepool.h
+///
+/// Slab allocator used by prqueue for its NODEs. Storage is carved out of
+/// slabs of growing size and freed nodes go on a freelist, so steady-state
+/// enqueue/dequeue churn never reaches the global allocator. All slabs are
+/// released at once by release().
+///
+/// Slabs come from Allocator (rebound to the slot type), so a pool can sit
+/// on top of std::pmr memory resources or any other standard allocator.
+/// The pool only hands out raw storage; constructing and destroying the
+/// objects placed in it is up to the caller.
+///
+/// reserve() preallocates slots ahead of a burst, shrink_to_fit() hands
+/// back slabs whose slots are all free, and memory_usage() reports the
+/// bytes currently held.
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <cstddef>
+
+using namespace std;
+
+template<typename U, typename Allocator = allocator<U>>
+class nodepool {
+private:
+    union SLOT {
+        SLOT* next;                               // links to next free slot
+        alignas(U) unsigned char storage[sizeof(U)]; // room for one U
+    };
+    struct SLAB {
+        SLOT* slots;   // first slot of the slab
+        size_t count;  // # of slots in the slab
+    };
+    using SlotAlloc = typename allocator_traits<Allocator>::template rebind_alloc<SLOT>;
+    using SlotTraits = allocator_traits<SlotAlloc>;
+    static const size_t MIN_SLAB = 16;    // slots in the first slab
+    static const size_t MAX_SLAB = 4096;  // slab growth stops here
+
+    SlotAlloc alloc;     // source of the slabs
+    vector<SLAB> slabs;  // every slab owned by the pool
+    SLOT* freeList;      // slots returned by deallocate
+    size_t freeCount;    // # of slots on freeList
+    SLOT* bump;          // next never-used slot of the newest slab
+    size_t bumpLeft;     // # of never-used slots left at bump
+
+    // allocates a slab of count slots and makes it the bump region
+    void addSlab(size_t count) {
+        SLOT *slots = SlotTraits::allocate(alloc, count);
+        slabs.push_back(SLAB{slots, count});
+        bump = slots;
+        bumpLeft = count;
+    }
+
+public:
+
+    // constructor:
+    // Creates a pool that owns no memory yet and takes its slabs from alloc.
+    // O(1)
+    explicit nodepool(const Allocator& alloc = Allocator()) : alloc(alloc) {
+        freeList = nullptr;
+        freeCount = 0;
+        bump = nullptr;
+        bumpLeft = 0;
+    }
+
+    // a pool owns its slabs, so it cannot be copied
+    nodepool(const nodepool&) = delete;
+    nodepool& operator=(const nodepool&) = delete;
+
+    // move constructor:
+    // Takes over every slab of other along with its allocator, leaving
+    // other empty.
+    // O(1)
+    nodepool(nodepool&& other) noexcept : alloc(std::move(other.alloc)) {
+        slabs.swap(other.slabs);
+        freeList = other.freeList;
+        freeCount = other.freeCount;
+        bump = other.bump;
+        bumpLeft = other.bumpLeft;
+        other.freeList = nullptr;
+        other.freeCount = 0;
+        other.bump = nullptr;
+        other.bumpLeft = 0;
+    }
+
+    // move assignment:
+    // Releases this pool's slabs and takes over other's, leaving other
+    // empty. The allocator comes along only if it propagates on move
+    // assignment; otherwise the two allocators must compare equal.
+    // O(s), where s is the number of slabs released
+    nodepool& operator=(nodepool&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        release();
+        if constexpr (SlotTraits::propagate_on_container_move_assignment::value) {
+            alloc = std::move(other.alloc);
+        }
+        slabs.swap(other.slabs);
+        freeList = other.freeList;
+        freeCount = other.freeCount;
+        bump = other.bump;
+        bumpLeft = other.bumpLeft;
+        other.freeList = nullptr;
+        other.freeCount = 0;
+        other.bump = nullptr;
+        other.bumpLeft = 0;
+        return *this;
+    }
+
+    // destructor:
+    // Releases every slab. Objects still in the pool are not destroyed.
+    // O(s), where s is the number of slabs
+    ~nodepool() {
+        release();
+    }
+
+    // returns a copy of the allocator the pool was built with
+    Allocator get_allocator() const {
+        return Allocator(alloc);
+    }
+
+    // allocate:
+    // Returns uninitialized storage for one U, reusing a freed slot if
+    // there is one.
+    // O(1), amortized over slab allocation
+    U* allocate() {
+        SLOT *slot;
+        if (freeList != nullptr) {
+            slot = freeList;
+            freeList = freeList->next;
+            freeCount--;
+        }
+        else {
+            // the next slab doubles the pool, up to MAX_SLAB slots
+            if (bumpLeft == 0) {
+                size_t count = slabs.empty() ? MIN_SLAB : slabs.back().count * 2;
+                addSlab(count < MAX_SLAB ? count : MAX_SLAB);
+            }
+            slot = bump++;
+            bumpLeft--;
+        }
+        return reinterpret_cast<U*>(slot->storage);
+    }
+
+    // deallocate:
+    // Returns storage from allocate to the freelist. The U in it must
+    // already be destroyed.
+    // O(1)
+    void deallocate(U* p) {
+        SLOT *slot = reinterpret_cast<SLOT*>(p);
+        slot->next = freeList;
+        freeList = slot;
+        freeCount++;
+    }
+
+    // adopt:
+    // Takes over every slab of other, which must use an equal allocator,
+    // so that objects allocated by other can be deallocated here. Free and
+    // never-used slots of other join the freelist. other is left empty.
+    // O(s + f), where s is other's # of slabs and f its # of free slots
+    void adopt(nodepool& other) {
+        if (this == &other) {
+            return;
+        }
+
+        slabs.insert(slabs.end(), other.slabs.begin(), other.slabs.end());
+        while (other.bumpLeft > 0) {
+            deallocate(reinterpret_cast<U*>((other.bump++)->storage));
+            other.bumpLeft--;
+        }
+        if (other.freeList != nullptr) {
+            SLOT *last = other.freeList;
+            while (last->next != nullptr) {
+                last = last->next;
+            }
+            last->next = freeList;
+            freeList = other.freeList;
+            freeCount += other.freeCount;
+        }
+
+        vector<SLAB>().swap(other.slabs);
+        other.freeList = nullptr;
+        other.freeCount = 0;
+        other.bump = nullptr;
+        other.bumpLeft = 0;
+    }
+
+    // reserve:
+    // Makes sure the next n calls to allocate need no new memory. Unused
+    // slots of the current slab are kept on the freelist and the shortfall
+    // comes in a single slab.
+    // O(b), where b is the # of never-used slots left in the newest slab
+    void reserve(size_t n) {
+        if (freeCount + bumpLeft >= n) {
+            return;
+        }
+
+        // retires what is left of the bump region to the freelist
+        while (bumpLeft > 0) {
+            deallocate(reinterpret_cast<U*>((bump++)->storage));
+            bumpLeft--;
+        }
+        addSlab(n - freeCount);
+    }
+
+    // shrink_to_fit:
+    // Returns every slab whose slots are all free to the allocator. Slabs
+    // that still hold a live U are kept.
+    // O(f logs + s logs), where f is the # of free slots and s the # of slabs
+    void shrink_to_fit() {
+        if (slabs.empty()) {
+            return;
+        }
+
+        // orders the slabs by address so that a slot can be mapped to its slab
+        vector<size_t> order(slabs.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return less<SLOT*>()(slabs[a].slots, slabs[b].slots);
+        });
+        auto slabOf = [&](SLOT* slot) {
+            auto it = upper_bound(order.begin(), order.end(), slot, [&](SLOT* p, size_t i) {
+                return less<SLOT*>()(p, slabs[i].slots);
+            });
+            return *(it - 1);
+        };
+
+        // counts the free slots in each slab
+        vector<size_t> freeIn(slabs.size(), 0);
+        for (SLOT *slot = freeList; slot != nullptr; slot = slot->next) {
+            freeIn[slabOf(slot)]++;
+        }
+        if (bumpLeft > 0) {
+            freeIn[slabOf(bump)] += bumpLeft;
+        }
+
+        // keeps only the free slots of slabs that stay
+        SLOT *kept = nullptr;
+        freeCount = 0;
+        SLOT *slot = freeList;
+        while (slot != nullptr) {
+            SLOT *nextSlot = slot->next;
+            size_t i = slabOf(slot);
+            if (freeIn[i] < slabs[i].count) {
+                slot->next = kept;
+                kept = slot;
+                freeCount++;
+            }
+            slot = nextSlot;
+        }
+        freeList = kept;
+        if (bumpLeft > 0 && freeIn[slabOf(bump)] == slabs[slabOf(bump)].count) {
+            bump = nullptr;
+            bumpLeft = 0;
+        }
+
+        // frees the empty slabs, the others keep their order
+        vector<SLAB> remaining;
+        for (size_t i = 0; i < slabs.size(); i++) {
+            if (freeIn[i] == slabs[i].count) {
+                SlotTraits::deallocate(alloc, slabs[i].slots, slabs[i].count);
+            }
+            else {
+                remaining.push_back(slabs[i]);
+            }
+        }
+        slabs.swap(remaining);
+    }
+
+    // capacity:
+    // Returns the # of U that fit in the slabs held right now.
+    // O(s), where s is the number of slabs
+    size_t capacity() const {
+        size_t total = 0;
+        for (const SLAB &slab : slabs) {
+            total += slab.count;
+        }
+        return total;
+    }
+
+    // memory_usage:
+    // Returns the bytes held by the pool: every slab plus the list that
+    // tracks them.
+    // O(s), where s is the number of slabs
+    size_t memory_usage() const {
+        return capacity() * sizeof(SLOT) + slabs.capacity() * sizeof(SLAB);
+    }
+
+    // release:
+    // Frees every slab at once. Any U still living in the pool must have
+    // been destroyed, or not need destroying.
+    // O(s), where s is the number of slabs
+    void release() {
+        for (const SLAB &slab : slabs) {
+            SlotTraits::deallocate(alloc, slab.slots, slab.count);
+        }
+        slabs.clear();
+        freeList = nullptr;
+        freeCount = 0;
+        bump = nullptr;
+        bumpLeft = 0;
+    }
+};
@@ -0,0 +1,406 @@
+/// @file prbitmap.h
+///
+/// Hierarchical bitmap engine for 32-bit int priorities, with the same
+/// interface as prqueue. Priorities are the keys of a sparse 64-ary trie
+/// in the spirit of a van Emde Boas tree: every node has a 64-bit
+/// occupancy word, so finding the minimum is one count-trailing-zeros per
+/// level and there are only 6 levels for the whole 32-bit range. Nodes are
+/// allocated on demand and freed when they empty. Leaves keep a FIFO per
+/// priority, so cost does not depend on insertion order.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <bit>
+#include <cstdint>
+
+using namespace std;
+
+template<typename T>
+class prbitmap {
+private:
+    static const int TOP_SHIFT = 30; // key bits used above each level: 30, 24, 18, 12, 6, 0
+
+    struct FIFO {
+        vector<T> items;  // values with one priority, in enqueue order
+        size_t head;      // index of the front item
+    };
+    struct INNER {
+        uint64_t bits;     // bit i is set when child[i] holds a priority
+        void* child[64];   // INNER* above shift 6, LEAF* at shift 6
+    };
+    struct LEAF {
+        uint64_t bits;     // bit i is set when slots[i] is non-empty
+        FIFO slots[64];    // FIFO for each of the 64 priorities of this leaf
+    };
+    INNER* root;        // top of the trie, covers bits 30-31 of the key
+    int sz;             // # of elements in the prqueue
+    bool iterating;     // true while begin/next has items left
+    unsigned currKey;   // key of next item (see begin and next)
+    size_t currItem;    // index of next item in its FIFO
+
+    // maps a priority onto an unsigned key with the same ordering
+    static unsigned keyOf(int priority) {
+        return (unsigned)priority ^ 0x80000000u;
+    }
+
+    // maps a key back onto its priority
+    static int priorityOf(unsigned key) {
+        return (int)(key ^ 0x80000000u);
+    }
+
+    // returns the child index of key in a node at the given shift
+    static unsigned indexOf(unsigned key, int shift) {
+        return (key >> shift) & 63;
+    }
+
+    // allocates an inner node with no children
+    static INNER* newInner() {
+        INNER *node = new INNER;
+        node->bits = 0;
+        return node;
+    }
+
+    // allocates a leaf with every FIFO empty
+    static LEAF* newLeaf() {
+        LEAF *leaf = new LEAF;
+        leaf->bits = 0;
+        for (int i = 0; i < 64; i++) {
+            leaf->slots[i].head = 0;
+        }
+        return leaf;
+    }
+
+    // frees the subtree below node, whose children sit at shift - 6
+    // O(n)
+    static void freeSubtree(INNER* node, int shift) {
+        uint64_t bits = node->bits;
+        while (bits != 0) {
+            int i = countr_zero(bits);
+            bits &= bits - 1;
+            if (shift == 6) {
+                delete (LEAF*)node->child[i];
+            }
+            else {
+                freeSubtree((INNER*)node->child[i], shift - 6);
+            }
+        }
+        delete node;
+    }
+
+    // copies the subtree below node, whose children sit at shift - 6
+    // O(n)
+    static INNER* copySubtree(const INNER* node, int shift) {
+        INNER *copied = newInner();
+        copied->bits = node->bits;
+
+        uint64_t bits = node->bits;
+        while (bits != 0) {
+            int i = countr_zero(bits);
+            bits &= bits - 1;
+            if (shift == 6) {
+                copied->child[i] = new LEAF(*(const LEAF*)node->child[i]);
+            }
+            else {
+                copied->child[i] = copySubtree((const INNER*)node->child[i], shift - 6);
+            }
+        }
+        return copied;
+    }
+
+    // minKey:
+    // Returns the smallest key stored below node, one tzcnt per level.
+    // O(1), 6 levels
+    static unsigned minKey(const INNER* node, int shift) {
+        unsigned key = 0;
+        while (true) {
+            unsigned i = countr_zero(node->bits);
+            key |= i << shift;
+            if (shift == 6) {
+                const LEAF *leaf = (const LEAF*)node->child[i];
+                return key | countr_zero(leaf->bits);
+            }
+            node = (const INNER*)node->child[i];
+            shift -= 6;
+        }
+    }
+
+    // ceiling:
+    // Finds the smallest stored key >= key below node. Returns false if
+    // there is none.
+    // O(1), 6 levels
+    static bool ceiling(const INNER* node, int shift, unsigned key, unsigned& out) {
+        unsigned i = indexOf(key, shift);
+
+        // looks inside the child that key falls into
+        if ((node->bits >> i) & 1) {
+            if (shift == 6) {
+                const LEAF *leaf = (const LEAF*)node->child[i];
+                uint64_t later = leaf->bits & (~0ULL << (key & 63));
+                if (later != 0) {
+                    out = (key & ~63u) | countr_zero(later);
+                    return true;
+                }
+            }
+            else if (ceiling((const INNER*)node->child[i], shift - 6, key, out)) {
+                return true;
+            }
+        }
+
+        // otherwise takes the minimum of the next occupied child
+        uint64_t later = (i == 63) ? 0 : node->bits & (~0ULL << (i + 1));
+        if (later == 0) {
+            return false;
+        }
+        unsigned c = countr_zero(later);
+        unsigned long long above = ~((1ULL << (shift + 6)) - 1);
+        unsigned base = (unsigned)(key & above) | (c << shift);
+
+        if (shift == 6) {
+            out = base | countr_zero(((const LEAF*)node->child[c])->bits);
+        }
+        else {
+            out = base | minKey((const INNER*)node->child[c], shift - 6);
+        }
+        return true;
+    }
+
+    // returns the FIFO for key, which must be stored
+    FIFO& slotOf(unsigned key) const {
+        INNER *node = root;
+        for (int shift = TOP_SHIFT; shift > 6; shift -= 6) {
+            node = (INNER*)node->child[indexOf(key, shift)];
+        }
+        LEAF *leaf = (LEAF*)node->child[indexOf(key, 6)];
+        return leaf->slots[key & 63];
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue.
+    // O(1)
+    prbitmap() {
+        root = newInner();
+        sz = 0;
+        iterating = false;
+        currKey = 0;
+        currItem = 0;
+    }
+
+    // copy constructor:
+    // Makes a deep copy of other.
+    // O(n)
+    prbitmap(const prbitmap& other) {
+        root = copySubtree(other.root, TOP_SHIFT);
+        sz = other.sz;
+        iterating = false;
+        currKey = 0;
+        currItem = 0;
+    }
+
+    // operator=
+    // Clears "this" trie and then makes a copy of the "other" trie.
+    // O(n)
+    prbitmap& operator=(const prbitmap& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        freeSubtree(root, TOP_SHIFT);
+        root = copySubtree(other.root, TOP_SHIFT);
+        sz = other.sz;
+        iterating = false;
+        return *this;
+    }
+
+    // clear:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    void clear() {
+        freeSubtree(root, TOP_SHIFT);
+        root = newInner();
+        sz = 0;
+        iterating = false;
+    }
+
+    // destructor:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    ~prbitmap() {
+        freeSubtree(root, TOP_SHIFT);
+    }
+
+    // enqueue:
+    // Sets the bits for priority on every level, allocating missing nodes,
+    // and appends the value to the FIFO of that priority.
+    // O(1), 6 levels
+    void enqueue(T value, int priority) {
+        unsigned key = keyOf(priority);
+
+        INNER *node = root;
+        for (int shift = TOP_SHIFT; shift > 6; shift -= 6) {
+            unsigned i = indexOf(key, shift);
+            if (((node->bits >> i) & 1) == 0) {
+                node->child[i] = newInner();
+                node->bits |= 1ULL << i;
+            }
+            node = (INNER*)node->child[i];
+        }
+
+        unsigned i = indexOf(key, 6);
+        if (((node->bits >> i) & 1) == 0) {
+            node->child[i] = newLeaf();
+            node->bits |= 1ULL << i;
+        }
+
+        LEAF *leaf = (LEAF*)node->child[i];
+        leaf->bits |= 1ULL << (key & 63);
+        leaf->slots[key & 63].items.push_back(std::move(value));
+        sz++;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(1), 6 levels
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (sz == 0) {
+            return T();
+        }
+
+        // follows the lowest set bit down, remembering the path
+        INNER *path[6];
+        unsigned pathIdx[6];
+        INNER *node = root;
+        int depth = 0;
+        for (int shift = TOP_SHIFT; shift >= 6; shift -= 6) {
+            unsigned i = countr_zero(node->bits);
+            path[depth] = node;
+            pathIdx[depth] = i;
+            depth++;
+            if (shift > 6) {
+                node = (INNER*)node->child[i];
+            }
+        }
+
+        LEAF *leaf = (LEAF*)path[depth - 1]->child[pathIdx[depth - 1]];
+        unsigned s = countr_zero(leaf->bits);
+        FIFO &slot = leaf->slots[s];
+        T valueOut = std::move(slot.items[slot.head]);
+        slot.head++;
+        sz--;
+
+        // drops the consumed front of a long-lived FIFO, amortized O(1)
+        if (slot.head < slot.items.size()) {
+            if (slot.head >= 32 && slot.head * 2 >= slot.items.size()) {
+                slot.items.erase(slot.items.begin(), slot.items.begin() + slot.head);
+                slot.head = 0;
+            }
+            return valueOut;
+        }
+
+        // the priority is used up, clears its bit and frees empty nodes
+        slot.items.clear();
+        slot.head = 0;
+        leaf->bits &= ~(1ULL << s);
+        if (leaf->bits != 0) {
+            return valueOut;
+        }
+        delete leaf;
+
+        for (int d = depth - 1; d >= 0; d--) {
+            path[d]->bits &= ~(1ULL << pathIdx[d]);
+            if (path[d]->bits != 0 || d == 0) {
+                break;
+            }
+            delete path[d];
+        }
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1), 6 levels
+    void begin() {
+        iterating = sz > 0;
+        if (iterating) {
+            currKey = minKey(root, TOP_SHIFT);
+            currItem = slotOf(currKey).head;
+        }
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1), 6 levels
+    bool next(T& value, int &priority) {
+        if (!iterating) {
+            return false;
+        }
+
+        FIFO &slot = slotOf(currKey);
+        value = slot.items[currItem];
+        priority = priorityOf(currKey);
+
+        // advances within the FIFO, then to the next stored priority
+        currItem++;
+        if (currItem == slot.items.size()) {
+            iterating = currKey != ~0u && ceiling(root, TOP_SHIFT, currKey + 1, currKey);
+            if (iterating) {
+                currItem = slotOf(currKey).head;
+            }
+        }
+
+        return iterating;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n)
+    string toString() {
+        stringstream ss;
+        if (sz == 0) {
+            return ss.str();
+        }
+
+        unsigned key = minKey(root, TOP_SHIFT);
+        while (true) {
+            const FIFO &slot = slotOf(key);
+            for (size_t j = slot.head; j < slot.items.size(); j++) {
+                ss << priorityOf(key) << " value: " << slot.items[j] << endl;
+            }
+            if (key == ~0u || !ceiling(root, TOP_SHIFT, key + 1, key)) {
+                break;
+            }
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1), 6 levels
+    T peek() {
+        if (sz == 0) {
+            return T();
+        }
+        const FIFO &slot = slotOf(minKey(root, TOP_SHIFT));
+        return slot.items[slot.head];
+    }
+};
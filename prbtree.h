@@ -0,0 +1,537 @@
+/// @file prbtree.h
+///
+/// B+tree engine with the same interface as prqueue, laid out for large
+/// queues. Each inner node packs 16 int priorities into one 64-byte cache
+/// line and searches them with SSE2 compares (a scalar loop is used when
+/// SSE2 is unavailable). Leaves hold up to 16 distinct priorities, each
+/// with a FIFO of values, and are chained so that toString and next are
+/// sequential scans.
+///
+/// Elements are only ever removed from the leftmost leaf, so nodes on the
+/// left spine are allowed to run underfull instead of being merged.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <bit>
+#include <climits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+template<typename T>
+class prbtree {
+private:
+    static const int KEYS = 16;        // priorities per node, one cache line
+    static const int MAX_HEIGHT = 32;  // deeper than any reachable tree
+
+    struct FIFO {
+        vector<T> items;  // values with one priority, in enqueue order
+        size_t head;      // index of the front item
+    };
+    struct INNER {
+        alignas(64) int keys[KEYS]; // separators, child i holds [keys[i-1], keys[i])
+        int n;                      // # of keys in use, children has n+1
+        void* children[KEYS + 1];   // INNER* or LEAF*, depending on height
+    };
+    struct LEAF {
+        alignas(64) int keys[KEYS]; // distinct priorities in ascending order
+        int n;                      // # of keys in use
+        LEAF* next;                 // links to leaf with the next larger keys
+        FIFO slots[KEYS];           // slots[i] holds the values for keys[i]
+    };
+    void* root;       // INNER* when height > 0, otherwise LEAF* (or null)
+    int height;       // # of inner levels above the leaves
+    int sz;           // # of elements in the prqueue
+    LEAF* first;      // leftmost leaf, holds the minimum
+    LEAF* currLeaf;   // leaf of next item (see begin and next)
+    int currSlot;     // slot of next item in currLeaf
+    size_t currItem;  // index of next item in the slot
+
+    // countLessEq:
+    // Returns how many of the first n keys are <= priority. The keys must
+    // be 64-byte aligned with all 16 entries initialized.
+    // O(1)
+    static int countLessEq(const int* keys, int n, int priority) {
+#if defined(__SSE2__)
+        __m128i p = _mm_set1_epi32(priority);
+        unsigned greater = 0;
+
+        // one compare per 4 keys, collecting the sign bits of keys > priority
+        for (int i = 0; i < KEYS / 4; i++) {
+            __m128i k = _mm_load_si128((const __m128i*)(keys + 4 * i));
+            __m128i gt = _mm_cmpgt_epi32(k, p);
+            greater |= (unsigned)_mm_movemask_ps(_mm_castsi128_ps(gt)) << (4 * i);
+        }
+
+        unsigned valid = (1u << n) - 1;
+        return popcount(~greater & valid);
+#else
+        int i = 0;
+        while (i < n && keys[i] <= priority) {
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    // returns how many of the first n keys are < priority
+    static int countLess(const int* keys, int n, int priority) {
+        if (priority == INT_MIN) {
+            return 0;
+        }
+        return countLessEq(keys, n, priority - 1);
+    }
+
+    // allocates an empty inner node with its keys padded out
+    static INNER* newInner() {
+        INNER *node = new INNER;
+        for (int i = 0; i < KEYS; i++) {
+            node->keys[i] = INT_MAX;
+        }
+        node->n = 0;
+        return node;
+    }
+
+    // allocates an empty leaf with its keys padded out
+    static LEAF* newLeaf() {
+        LEAF *leaf = new LEAF;
+        for (int i = 0; i < KEYS; i++) {
+            leaf->keys[i] = INT_MAX;
+            leaf->slots[i].head = 0;
+        }
+        leaf->n = 0;
+        leaf->next = nullptr;
+        return leaf;
+    }
+
+    // frees the subtree rooted at node, h levels above the leaves
+    // O(n)
+    static void freeSubtree(void* node, int h) {
+        if (h == 0) {
+            delete (LEAF*)node;
+            return;
+        }
+
+        INNER *inner = (INNER*)node;
+        for (int i = 0; i <= inner->n; i++) {
+            freeSubtree(inner->children[i], h - 1);
+        }
+        delete inner;
+    }
+
+    // copies the subtree rooted at node, h levels above the leaves, and
+    // chains its leaves after prevLeaf
+    // O(n)
+    static void* copySubtree(void* node, int h, LEAF*& prevLeaf, LEAF*& firstLeaf) {
+        if (h == 0) {
+            LEAF *leaf = new LEAF(*(LEAF*)node);
+            leaf->next = nullptr;
+            if (prevLeaf == nullptr) {
+                firstLeaf = leaf;
+            }
+            else {
+                prevLeaf->next = leaf;
+            }
+            prevLeaf = leaf;
+            return leaf;
+        }
+
+        INNER *inner = new INNER(*(INNER*)node);
+        for (int i = 0; i <= inner->n; i++) {
+            inner->children[i] = copySubtree(inner->children[i], h - 1, prevLeaf, firstLeaf);
+        }
+        return inner;
+    }
+
+    // insertLeafSlot:
+    // Opens a slot for priority at index pos of leaf, which must not be full.
+    // O(KEYS)
+    static void insertLeafSlot(LEAF* leaf, int pos, int priority) {
+        for (int i = leaf->n; i > pos; i--) {
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->slots[i].items.swap(leaf->slots[i - 1].items);
+            leaf->slots[i].head = leaf->slots[i - 1].head;
+        }
+        leaf->keys[pos] = priority;
+        leaf->slots[pos].items.clear();
+        leaf->slots[pos].head = 0;
+        leaf->n++;
+    }
+
+    // splitLeaf:
+    // Moves the upper half of a full leaf into a new leaf chained after it.
+    // Returns the new leaf; its first key is the separator for the parent.
+    // O(KEYS)
+    static LEAF* splitLeaf(LEAF* leaf) {
+        LEAF *right = newLeaf();
+        int half = KEYS / 2;
+        for (int i = half; i < KEYS; i++) {
+            right->keys[i - half] = leaf->keys[i];
+            right->slots[i - half].items.swap(leaf->slots[i].items);
+            right->slots[i - half].head = leaf->slots[i].head;
+            leaf->keys[i] = INT_MAX;
+        }
+        right->n = KEYS - half;
+        leaf->n = half;
+
+        right->next = leaf->next;
+        leaf->next = right;
+        return right;
+    }
+
+    // insertChild:
+    // Adds separator key and the child to its right at position pos of a
+    // node that is not full.
+    // O(KEYS)
+    static void insertChild(INNER* node, int pos, int key, void* child) {
+        for (int i = node->n; i > pos; i--) {
+            node->keys[i] = node->keys[i - 1];
+            node->children[i + 1] = node->children[i];
+        }
+        node->keys[pos] = key;
+        node->children[pos + 1] = child;
+        node->n++;
+    }
+
+    // splitInner:
+    // Moves the upper half of a full inner node into a new node. The middle
+    // key is removed and returned through upKey for the parent.
+    // O(KEYS)
+    static INNER* splitInner(INNER* node, int& upKey) {
+        INNER *right = newInner();
+        int half = KEYS / 2;
+        upKey = node->keys[half];
+
+        for (int i = half + 1; i < KEYS; i++) {
+            right->keys[i - half - 1] = node->keys[i];
+            right->children[i - half - 1] = node->children[i];
+            node->keys[i] = INT_MAX;
+        }
+        right->children[KEYS - half - 1] = node->children[KEYS];
+        right->n = KEYS - half - 1;
+
+        node->keys[half] = INT_MAX;
+        node->n = half;
+        return right;
+    }
+
+    // removeFirstLeaf:
+    // Unlinks the leftmost leaf, which has become empty, together with any
+    // inner nodes on the left spine that are left without children.
+    // O(logn)
+    void removeFirstLeaf() {
+        LEAF *empty = first;
+        first = empty->next;
+
+        if (height == 0) {
+            delete empty;
+            root = first;
+            return;
+        }
+
+        // collects the left spine down to the parent of the leaf
+        INNER *spine[MAX_HEIGHT];
+        INNER *node = (INNER*)root;
+        for (int h = height; h > 0; h--) {
+            spine[h] = node;
+            node = (INNER*)node->children[0];
+        }
+        delete empty;
+
+        // drops child 0 from each spine node, stopping at one that survives
+        for (int h = 1; h <= height; h++) {
+            INNER *parent = spine[h];
+            if (parent->n > 0) {
+                for (int i = 0; i < parent->n; i++) {
+                    parent->children[i] = parent->children[i + 1];
+                }
+                for (int i = 0; i < parent->n - 1; i++) {
+                    parent->keys[i] = parent->keys[i + 1];
+                }
+                parent->n--;
+                parent->keys[parent->n] = INT_MAX;
+                break;
+            }
+
+            // parent had no other child, it goes away as well
+            delete parent;
+            if (h == height) {
+                root = nullptr;
+                height = 0;
+                return;
+            }
+        }
+
+        // shrinks the tree while the root has a single child
+        while (height > 0 && ((INNER*)root)->n == 0) {
+            INNER *oldRoot = (INNER*)root;
+            root = oldRoot->children[0];
+            delete oldRoot;
+            height--;
+        }
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue.
+    // O(1)
+    prbtree() {
+        root = nullptr;
+        height = 0;
+        sz = 0;
+        first = nullptr;
+        currLeaf = nullptr;
+        currSlot = 0;
+        currItem = 0;
+    }
+
+    // copy constructor:
+    // Makes a deep copy of other with the same node layout.
+    // O(n)
+    prbtree(const prbtree& other) : prbtree() {
+        *this = other;
+    }
+
+    // operator=
+    // Clears "this" tree and then makes a copy of the "other" tree.
+    // O(n)
+    prbtree& operator=(const prbtree& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        if (other.root != nullptr) {
+            LEAF *prevLeaf = nullptr;
+            root = copySubtree(other.root, other.height, prevLeaf, first);
+        }
+        height = other.height;
+        sz = other.sz;
+        return *this;
+    }
+
+    // clear:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    void clear() {
+        if (root != nullptr) {
+            freeSubtree(root, height);
+        }
+        root = nullptr;
+        height = 0;
+        sz = 0;
+        first = nullptr;
+        currLeaf = nullptr;
+    }
+
+    // destructor:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    ~prbtree() {
+        clear();
+    }
+
+    // enqueue:
+    // Descends to the leaf for priority and appends the value to the FIFO of
+    // that priority, splitting full nodes on the way back up.
+    // O(logn)
+    void enqueue(T value, int priority) {
+        if (root == nullptr) {
+            root = first = newLeaf();
+        }
+
+        // descends, remembering the path for splits
+        INNER *path[MAX_HEIGHT];
+        int pathIdx[MAX_HEIGHT];
+        void *node = root;
+        for (int h = height; h > 0; h--) {
+            INNER *inner = (INNER*)node;
+            int idx = countLessEq(inner->keys, inner->n, priority);
+            path[h] = inner;
+            pathIdx[h] = idx;
+            node = inner->children[idx];
+        }
+
+        LEAF *leaf = (LEAF*)node;
+        int pos = countLess(leaf->keys, leaf->n, priority);
+        sz++;
+
+        // an existing priority only grows its FIFO
+        if (pos < leaf->n && leaf->keys[pos] == priority) {
+            leaf->slots[pos].items.push_back(std::move(value));
+            return;
+        }
+
+        // splits a full leaf first, then opens the slot in the right half
+        void *newChild = nullptr;
+        int upKey = 0;
+        if (leaf->n == KEYS) {
+            LEAF *right = splitLeaf(leaf);
+            newChild = right;
+            upKey = right->keys[0];
+            if (pos > leaf->n) {
+                pos -= leaf->n;
+                leaf = right;
+            }
+        }
+        insertLeafSlot(leaf, pos, priority);
+        leaf->slots[pos].items.push_back(std::move(value));
+
+        // pushes the separator up, splitting inner nodes as needed
+        for (int h = 1; h <= height && newChild != nullptr; h++) {
+            INNER *parent = path[h];
+            int idx = pathIdx[h];
+
+            if (parent->n < KEYS) {
+                insertChild(parent, idx, upKey, newChild);
+                newChild = nullptr;
+            }
+            else {
+                int midKey;
+                INNER *right = splitInner(parent, midKey);
+                if (idx <= parent->n) {
+                    insertChild(parent, idx, upKey, newChild);
+                }
+                else {
+                    insertChild(right, idx - parent->n - 1, upKey, newChild);
+                }
+                newChild = right;
+                upKey = midKey;
+            }
+        }
+
+        // the root itself split, grows the tree by a level
+        if (newChild != nullptr) {
+            INNER *newRoot = newInner();
+            newRoot->keys[0] = upKey;
+            newRoot->children[0] = root;
+            newRoot->children[1] = newChild;
+            newRoot->n = 1;
+            root = newRoot;
+            height++;
+        }
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(1), plus O(logn) each time the leftmost leaf empties
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (sz == 0) {
+            return T();
+        }
+
+        FIFO &slot = first->slots[0];
+        T valueOut = std::move(slot.items[slot.head]);
+        slot.head++;
+        sz--;
+
+        // the priority is used up, closes its slot
+        if (slot.head == slot.items.size()) {
+            for (int i = 1; i < first->n; i++) {
+                first->keys[i - 1] = first->keys[i];
+                first->slots[i - 1].items.swap(first->slots[i].items);
+                first->slots[i - 1].head = first->slots[i].head;
+            }
+            first->n--;
+            first->keys[first->n] = INT_MAX;
+            first->slots[first->n].items.clear();
+            first->slots[first->n].head = 0;
+
+            if (first->n == 0) {
+                removeFirstLeaf();
+            }
+        }
+
+        // drops the consumed front of a long-lived FIFO, amortized O(1)
+        else if (slot.head >= 32 && slot.head * 2 >= slot.items.size()) {
+            slot.items.erase(slot.items.begin(), slot.items.begin() + slot.head);
+            slot.head = 0;
+        }
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1)
+    void begin() {
+        currLeaf = first;
+        currSlot = 0;
+        currItem = (first != nullptr) ? first->slots[0].head : 0;
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1)
+    bool next(T& value, int &priority) {
+        if (currLeaf == nullptr) {
+            return false;
+        }
+
+        value = currLeaf->slots[currSlot].items[currItem];
+        priority = currLeaf->keys[currSlot];
+
+        // advances within the FIFO, then the leaf, then along the leaf chain
+        currItem++;
+        if (currItem == currLeaf->slots[currSlot].items.size()) {
+            currSlot++;
+            if (currSlot == currLeaf->n) {
+                currLeaf = currLeaf->next;
+                currSlot = 0;
+            }
+            if (currLeaf != nullptr) {
+                currItem = currLeaf->slots[currSlot].head;
+            }
+        }
+
+        return currLeaf != nullptr;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n)
+    string toString() {
+        stringstream ss;
+        for (LEAF *leaf = first; leaf != nullptr; leaf = leaf->next) {
+            for (int i = 0; i < leaf->n; i++) {
+                const FIFO &slot = leaf->slots[i];
+                for (size_t j = slot.head; j < slot.items.size(); j++) {
+                    ss << leaf->keys[i] << " value: " << slot.items[j] << endl;
+                }
+            }
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (sz == 0) {
+            return T();
+        }
+        return first->slots[0].items[first->slots[0].head];
+    }
+};
@@ -0,0 +1,280 @@
+/// @file prbucket.h
+///
+/// Bucket queue engine for small, dense priority ranges, with the same
+/// interface as prqueue. Priorities must lie in [minPriority, maxPriority]
+/// given to the constructor. Each bucket is a FIFO and an occupancy bitmap
+/// finds the first non-empty bucket with a find-first-set.
+///
+/// With a width of 1 every bucket holds one priority, so enqueue is O(1).
+/// A larger width turns it into a calendar queue for wider ranges: each
+/// bucket ("day") covers width consecutive priorities and keeps them sorted,
+/// with ties in FIFO order.
+///
+/// A bucket is just the head and tail index of a list threaded through one
+/// shared entry array, so empty buckets cost 8 bytes each and storage grows
+/// with the # of elements, not with the range. Priorities outside the range
+/// throw out_of_range.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+template<typename T>
+class prbucket {
+private:
+    static const int NONE = -1;  // null entry index
+
+    struct ENTRY {
+        int priority;  // used to pick the bucket and order within it
+        int next;      // next entry of the bucket, or of the freelist
+        T value;       // stored data for the p-queue
+    };
+    struct DAY {
+        int head;      // first entry of the bucket, NONE if empty
+        int tail;      // last entry of the bucket
+    };
+    int lo;                    // smallest allowed priority
+    int hi;                    // largest allowed priority
+    int width;                 // # of priorities covered by one bucket
+    vector<DAY> days;          // buckets, each sorted with ties in FIFO order
+    vector<ENTRY> entries;     // storage for the entries of every bucket
+    int freeEntries;           // first unused slot of entries, NONE if none
+    vector<uint64_t> occupied; // bit d is set when days[d] is non-empty
+    size_t lowWord;            // no bits are set in words below this one
+    int sz;                    // # of elements in the prqueue
+    size_t currDay;            // bucket of next item (see begin and next)
+    int currEntry;             // entry of next item within currDay
+
+    // returns the first non-empty bucket at or after day, or days.size()
+    // O(U/64) worst case, where U is the number of buckets
+    size_t firstDay(size_t day) const {
+        size_t w = day / 64;
+        if (w >= occupied.size()) {
+            return days.size();
+        }
+
+        // masks off the buckets before day in its own word
+        uint64_t bits = occupied[w] & (~0ULL << (day % 64));
+        while (bits == 0) {
+            w++;
+            if (w >= occupied.size()) {
+                return days.size();
+            }
+            bits = occupied[w];
+        }
+        return w * 64 + countr_zero(bits);
+    }
+
+    // stores an entry in a free slot, or a new one, and returns its index
+    // O(1), amortized over growing entries
+    int newEntry(int priority, T&& value) {
+        if (freeEntries == NONE) {
+            entries.push_back(ENTRY{priority, NONE, std::move(value)});
+            return (int)entries.size() - 1;
+        }
+
+        int e = freeEntries;
+        freeEntries = entries[e].next;
+        entries[e].priority = priority;
+        entries[e].next = NONE;
+        entries[e].value = std::move(value);
+        return e;
+    }
+
+    // returns the first non-empty bucket, using lowWord to skip empty words
+    size_t minDay() {
+        size_t day = firstDay(lowWord * 64);
+        lowWord = day / 64;
+        return day;
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue for priorities in [minPriority,
+    // maxPriority], with width priorities per bucket. Throws
+    // invalid_argument for an empty range or a width below 1.
+    // O(U), where U is the number of buckets
+    explicit prbucket(int minPriority = 0, int maxPriority = 255, int width = 1) {
+        if (minPriority > maxPriority || width < 1) {
+            throw invalid_argument("prbucket needs minPriority <= maxPriority and width >= 1");
+        }
+        lo = minPriority;
+        hi = maxPriority;
+        this->width = width;
+
+        size_t numDays = (size_t)(((long long)hi - lo) / width + 1);
+        days.assign(numDays, DAY{NONE, NONE});
+        freeEntries = NONE;
+        occupied.assign((numDays + 63) / 64, 0);
+        lowWord = occupied.size();
+        sz = 0;
+        currDay = numDays;
+        currEntry = NONE;
+    }
+
+    // clear:
+    // Removes every element from the priority queue and frees the entry
+    // storage.
+    // O(U/64 + n), where U is the number of buckets
+    void clear() {
+        for (size_t w = 0; w < occupied.size(); w++) {
+            while (occupied[w] != 0) {
+                int bit = countr_zero(occupied[w]);
+                days[w * 64 + bit] = DAY{NONE, NONE};
+                occupied[w] &= occupied[w] - 1;
+            }
+        }
+        vector<ENTRY>().swap(entries);
+        freeEntries = NONE;
+        lowWord = occupied.size();
+        sz = 0;
+        currDay = days.size();
+        currEntry = NONE;
+    }
+
+    // enqueue:
+    // Inserts the value in the bucket for its priority, after any equal
+    // priorities. Throws out_of_range if the priority is outside the
+    // constructed range.
+    // O(1) for width 1, otherwise O(k) where k is the size of the bucket
+    void enqueue(T value, int priority) {
+        if (priority < lo || priority > hi) {
+            throw out_of_range("prbucket priority out of range");
+        }
+
+        size_t day = (size_t)(((long long)priority - lo) / width);
+        int e = newEntry(priority, std::move(value));
+        DAY &bucket = days[day];
+
+        // appends in O(1) when nothing larger is in the bucket, which is
+        // always the case for width 1
+        if (bucket.head == NONE) {
+            bucket.head = e;
+            bucket.tail = e;
+        }
+        else if (entries[bucket.tail].priority <= priority) {
+            entries[bucket.tail].next = e;
+            bucket.tail = e;
+        }
+        else if (entries[bucket.head].priority > priority) {
+            entries[e].next = bucket.head;
+            bucket.head = e;
+        }
+        else {
+            // walks to the last entry with a priority <= priority
+            int prev = bucket.head;
+            while (entries[entries[prev].next].priority <= priority) {
+                prev = entries[prev].next;
+            }
+            entries[e].next = entries[prev].next;
+            entries[prev].next = e;
+        }
+
+        occupied[day / 64] |= 1ULL << (day % 64);
+        lowWord = min(lowWord, day / 64);
+        sz++;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(1) plus a find-first-set over the bitmap
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (sz == 0) {
+            return T();
+        }
+
+        size_t day = minDay();
+        DAY &bucket = days[day];
+        int e = bucket.head;
+        T valueOut = std::move(entries[e].value);
+        bucket.head = entries[e].next;
+        entries[e].next = freeEntries;
+        freeEntries = e;
+
+        // marks the bucket empty in the bitmap
+        if (bucket.head == NONE) {
+            bucket.tail = NONE;
+            occupied[day / 64] &= ~(1ULL << (day % 64));
+        }
+        sz--;
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1) plus a find-first-set over the bitmap
+    void begin() {
+        currDay = (sz == 0) ? days.size() : minDay();
+        currEntry = (sz == 0) ? NONE : days[currDay].head;
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1) plus a find-first-set over the bitmap
+    bool next(T& value, int &priority) {
+        if (currDay >= days.size()) {
+            return false;
+        }
+
+        const ENTRY &e = entries[currEntry];
+        value = e.value;
+        priority = e.priority;
+
+        // advances within the bucket, then to the next non-empty bucket
+        currEntry = e.next;
+        if (currEntry == NONE) {
+            currDay = firstDay(currDay + 1);
+            currEntry = (currDay < days.size()) ? days[currDay].head : NONE;
+        }
+
+        return currDay < days.size();
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n) plus a find-first-set per bucket
+    string toString() {
+        stringstream ss;
+        for (size_t day = firstDay(0); day < days.size(); day = firstDay(day + 1)) {
+            for (int e = days[day].head; e != NONE; e = entries[e].next) {
+                ss << entries[e].priority << " value: " << entries[e].value << endl;
+            }
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1) plus a find-first-set over the bitmap
+    T peek() {
+        if (sz == 0) {
+            return T();
+        }
+        return entries[days[minDay()].head].value;
+    }
+};
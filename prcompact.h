@@ -0,0 +1,508 @@
+/// @file prcompact.h
+///
+/// Compact variant of prqueue for very large queues. It is the same BST
+/// with the same optional red-black balancing (rbtree.h), but all NODEs
+/// live in one growable vector and refer to each other with 32-bit indices
+/// instead of 64-bit pointers. That keeps nodes dense in memory and makes
+/// operator= a plain array copy. Freed slots are reused through a freelist.
+///
+/// There is only one NODE per distinct priority. The first value at a
+/// priority is stored inline in its NODE and later ones go into a chunked
+/// FIFO of BLOCKs hanging off it, so a duplicate costs about sizeof(T) and
+/// dequeuing within a priority is an index bump.
+///
+/// Payloads are kept out of the tree: NODEs hold only priorities, links
+/// and flags, and the inline value of node i is values[i]. Walking the
+/// tree to enqueue or to find the minimum only touches the dense NODE
+/// array, however large T is.
+///
+/// The 32-bit indices cap a queue at 2^32 - 1 distinct priorities and as
+/// many BLOCKs; enqueue throws length_error rather than wrap around.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <stdexcept>
+#include "rbtree.h"
+
+using namespace std;
+
+template<typename T>
+class prcompact {
+private:
+    static const uint32_t NIL = 0xFFFFFFFFu; // stands for a null link
+
+    // values per BLOCK, about 256 bytes worth but at least 8
+    static const uint32_t BLOCK_ITEMS = (sizeof(T) >= 32) ? 8 : (uint32_t)(256 / sizeof(T));
+
+    struct NODE {
+        int priority;        // used to build BST
+        uint32_t parent;     // links back to parent, or next free slot
+        uint32_t left;       // links to left child
+        uint32_t right;      // links to right child
+        uint32_t headBlock;  // first BLOCK of later values at this priority, NIL if none
+        uint32_t tailBlock;  // last BLOCK of later values at this priority, NIL if none
+        bool red;            // red-black color, only maintained in balanced mode
+        bool hasValue;       // false once values[node] has been dequeued
+    };
+    struct BLOCK {
+        uint32_t next;          // links to next BLOCK of the same priority, or next free block
+        uint32_t begin;         // index of the front item
+        uint32_t end;           // one past the back item
+        T items[BLOCK_ITEMS];   // values at one priority, in enqueue order
+    };
+    vector<NODE> nodes;   // every NODE, indexed by the links above
+    vector<T> values;     // first value enqueued at each node's priority, parallel to nodes
+    vector<BLOCK> blocks; // every BLOCK, indexed by headBlock/tailBlock/next
+    uint32_t freeHead;    // first free slot in nodes
+    uint32_t freeBlocks;  // first free slot in blocks
+    uint32_t root;        // index of root node of the BST
+    uint32_t first;       // cached leftmost node, the next item to dequeue
+    uint32_t curr;        // node of next item in prqueue (see begin and next)
+    uint32_t currBlock;   // block of next item, NIL while on the inline value
+    uint32_t currItem;    // index of next item in currBlock
+    int sz;               // # of elements in the prqueue
+    bool balanced;        // keeps the BST red-black balanced when true
+
+    // allocates a red node with no links, reusing a free slot if possible
+    // O(1), amortized over growth of the array
+    uint32_t newNode(T&& value, int priority) {
+        uint32_t idx;
+        if (freeHead != NIL) {
+            idx = freeHead;
+            freeHead = nodes[idx].parent;
+            values[idx] = std::move(value);
+        }
+        else {
+            // index NIL would read as a null link
+            if (nodes.size() >= NIL) {
+                throw length_error("prcompact is out of 32-bit node indices");
+            }
+            idx = (uint32_t)nodes.size();
+            nodes.push_back(NODE{0, NIL, NIL, NIL, NIL, NIL, true, true});
+            values.push_back(std::move(value));
+        }
+
+        NODE &node = nodes[idx];
+        node.priority = priority;
+        node.parent = NIL;
+        node.left = NIL;
+        node.right = NIL;
+        node.headBlock = NIL;
+        node.tailBlock = NIL;
+        node.red = true;
+        node.hasValue = true;
+        return idx;
+    }
+
+    // puts a slot on the freelist, dropping the value it held
+    // O(1)
+    void freeNode(uint32_t idx) {
+        values[idx] = T();
+        nodes[idx].parent = freeHead;
+        freeHead = idx;
+    }
+
+    // allocates an empty block, reusing a free slot if possible
+    // O(1), amortized over growth of the array
+    uint32_t newBlock() {
+        uint32_t idx;
+        if (freeBlocks != NIL) {
+            idx = freeBlocks;
+            freeBlocks = blocks[idx].next;
+        }
+        else {
+            if (blocks.size() >= NIL) {
+                throw length_error("prcompact is out of 32-bit block indices");
+            }
+            idx = (uint32_t)blocks.size();
+            blocks.emplace_back();
+        }
+
+        blocks[idx].next = NIL;
+        blocks[idx].begin = 0;
+        blocks[idx].end = 0;
+        return idx;
+    }
+
+    // appends value to the FIFO of node, starting a new block when the
+    // last one is full
+    // O(1), amortized over growth of the array
+    void pushBack(uint32_t node, T&& value) {
+        uint32_t tail = nodes[node].tailBlock;
+        if (tail == NIL || blocks[tail].end == BLOCK_ITEMS) {
+            uint32_t added = newBlock();
+            if (tail == NIL) {
+                nodes[node].headBlock = added;
+            }
+            else {
+                blocks[tail].next = added;
+            }
+            nodes[node].tailBlock = added;
+            tail = added;
+        }
+
+        BLOCK &b = blocks[tail];
+        b.items[b.end++] = std::move(value);
+    }
+
+    // removes and returns the front value at node, freeing emptied blocks
+    // O(1)
+    T popFront(uint32_t node) {
+        NODE &n = nodes[node];
+        if (n.hasValue) {
+            n.hasValue = false;
+            return std::move(values[node]);
+        }
+
+        uint32_t head = n.headBlock;
+        BLOCK &b = blocks[head];
+        T valueOut = std::move(b.items[b.begin++]);
+        if (b.begin == b.end) {
+            n.headBlock = b.next;
+            if (n.headBlock == NIL) {
+                n.tailBlock = NIL;
+            }
+            b.next = freeBlocks;
+            freeBlocks = head;
+        }
+        return valueOut;
+    }
+
+    // returns the front value at node without removing it
+    const T& front(uint32_t node) const {
+        const NODE &n = nodes[node];
+        if (n.hasValue) {
+            return values[node];
+        }
+        const BLOCK &b = blocks[n.headBlock];
+        return b.items[b.begin];
+    }
+
+    // calls visit on every value at node, in FIFO order
+    template<typename F>
+    void forEachValue(uint32_t node, F visit) const {
+        if (nodes[node].hasValue) {
+            visit(values[node]);
+        }
+        for (uint32_t b = nodes[node].headBlock; b != NIL; b = blocks[b].next) {
+            for (uint32_t i = blocks[b].begin; i < blocks[b].end; i++) {
+                visit(blocks[b].items[i]);
+            }
+        }
+    }
+
+    // points the traversal at the front value of curr
+    void enterNode() {
+        if (curr == NIL || nodes[curr].hasValue) {
+            currBlock = NIL;
+        }
+        else {
+            currBlock = nodes[curr].headBlock;
+            currItem = blocks[currBlock].begin;
+        }
+    }
+
+    // Links for rbtree, following the 32-bit indices of nodes
+    struct LINKS {
+        using ref = uint32_t;
+        vector<NODE>* nodes;  // the node array the indices point into
+        uint32_t* rootLink;   // where the tree keeps its root
+
+        ref nil() const {
+            return NIL;
+        }
+        ref& root() {
+            return *rootLink;
+        }
+        ref& left(ref node) {
+            return (*nodes)[node].left;
+        }
+        ref& right(ref node) {
+            return (*nodes)[node].right;
+        }
+        ref& parent(ref node) {
+            return (*nodes)[node].parent;
+        }
+        bool& red(ref node) {
+            return (*nodes)[node].red;
+        }
+    };
+
+    // returns the red-black balancing code for this queue's BST
+    rbtree<LINKS> tree() {
+        return rbtree<LINKS>(LINKS{&nodes, &root});
+    }
+
+    // helper function for toString
+    void toStringHelper(uint32_t node, stringstream& ss) const {
+        if (node == NIL) {
+            return;
+        }
+
+        toStringHelper(nodes[node].left, ss);
+        int priority = nodes[node].priority;
+        forEachValue(node, [&](const T& value) {
+            ss << priority << " value: " << value << endl;
+        });
+        toStringHelper(nodes[node].right, ss);
+    }
+
+    // helper function for operator==, compares two subtrees node by node
+    // and the values at each priority in order
+    bool compareNodes(const prcompact& other, uint32_t a, uint32_t b) const {
+        if (a == NIL || b == NIL) {
+            return a == b;
+        }
+        if (nodes[a].priority != other.nodes[b].priority) {
+            return false;
+        }
+
+        vector<const T*> mine, theirs;
+        forEachValue(a, [&](const T& value) { mine.push_back(&value); });
+        other.forEachValue(b, [&](const T& value) { theirs.push_back(&value); });
+        if (mine.size() != theirs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < mine.size(); i++) {
+            if (*mine[i] != *theirs[i]) {
+                return false;
+            }
+        }
+
+        return compareNodes(other, nodes[a].left, other.nodes[b].left)
+            && compareNodes(other, nodes[a].right, other.nodes[b].right);
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue. When balanced is true the BST is
+    // kept red-black balanced.
+    // O(1)
+    explicit prcompact(bool balanced = false) {
+        freeHead = NIL;
+        freeBlocks = NIL;
+        root = NIL;
+        first = NIL;
+        curr = NIL;
+        currBlock = NIL;
+        currItem = 0;
+        sz = 0;
+        this->balanced = balanced;
+    }
+
+    // clear:
+    // Frees the memory associated with the priority queue.
+    // O(n), where n is total number of nodes in custom BST
+    void clear() {
+        nodes.clear();
+        values.clear();
+        blocks.clear();
+        freeHead = NIL;
+        freeBlocks = NIL;
+        root = NIL;
+        first = NIL;
+        curr = NIL;
+        currBlock = NIL;
+        sz = 0;
+    }
+
+    // enqueue:
+    // Inserts the value into the custom BST in the correct location based on
+    // priority, after any equal priorities. Only a new priority allocates a
+    // NODE, equal ones are appended to its FIFO.
+    // O(logn), where n is number of unique nodes in tree
+    void enqueue(T value, int priority) {
+        uint32_t parent = NIL;
+        bool goLeft = false;
+        uint32_t temp = root;
+        while (temp != NIL) {
+            parent = temp;
+            if (priority < nodes[temp].priority) {
+                goLeft = true;
+                temp = nodes[temp].left;
+            }
+            else if (priority > nodes[temp].priority) {
+                goLeft = false;
+                temp = nodes[temp].right;
+            }
+            else {
+                // appends to the FIFO, the tree shape is unchanged
+                pushBack(temp, std::move(value));
+                sz++;
+                return;
+            }
+        }
+
+        // growing the array invalidates references, so only indices are kept
+        uint32_t newIdx = newNode(std::move(value), priority);
+        nodes[newIdx].parent = parent;
+        sz++;
+
+        if (parent == NIL) {
+            root = newIdx;
+            first = newIdx;
+            nodes[newIdx].red = false;
+            return;
+        }
+
+        if (goLeft) {
+            nodes[parent].left = newIdx;
+            if (parent == first) {
+                first = newIdx;
+            }
+        }
+        else {
+            nodes[parent].right = newIdx;
+        }
+
+        if (balanced) {
+            tree().insertFixup(newIdx);
+        }
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(1) amortized, plus rebalancing in balanced mode
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (root == NIL) {
+            return T();
+        }
+
+        uint32_t toDelete = first;
+        T valueOut = popFront(toDelete);
+        sz--;
+
+        // other values are left at this priority, the tree is unchanged
+        if (nodes[toDelete].headBlock != NIL) {
+            return valueOut;
+        }
+
+        // the minimum has no left child, its right subtree moves up
+        uint32_t child = nodes[toDelete].right;
+        uint32_t parent = nodes[toDelete].parent;
+        tree().replaceChild(parent, toDelete, child);
+        if (child != NIL) {
+            nodes[child].parent = parent;
+            first = tree().leftmost(child);
+        }
+        else {
+            first = parent;
+        }
+
+        if (balanced && !nodes[toDelete].red) {
+            tree().eraseFixup(child, parent);
+        }
+
+        freeNode(toDelete);
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // memory_usage:
+    // Returns the bytes held by the node, value and block arrays, used or
+    // not. Memory owned by the values themselves is not counted.
+    // O(1)
+    size_t memory_usage() const {
+        return nodes.capacity() * sizeof(NODE) + values.capacity() * sizeof(T)
+             + blocks.capacity() * sizeof(BLOCK);
+    }
+
+    // node_bytes:
+    // Returns the size of one tree NODE. NODEs hold no T, so this is the
+    // same for every payload type. Used for testing the hot/cold layout.
+    // O(1)
+    static constexpr size_t node_bytes() {
+        return sizeof(NODE);
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1)
+    void begin() {
+        curr = first;
+        enterNode();
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1) within a priority, O(logn) to move to the next one
+    bool next(T& value, int &priority) {
+        if (curr == NIL) {
+            return false;
+        }
+
+        priority = nodes[curr].priority;
+
+        // steps through the FIFO: inline value first, then each block
+        if (currBlock == NIL) {
+            value = values[curr];
+            currBlock = nodes[curr].headBlock;
+            if (currBlock != NIL) {
+                currItem = blocks[currBlock].begin;
+                return true;
+            }
+        }
+        else {
+            value = blocks[currBlock].items[currItem++];
+            if (currItem < blocks[currBlock].end) {
+                return true;
+            }
+            currBlock = blocks[currBlock].next;
+            if (currBlock != NIL) {
+                currItem = blocks[currBlock].begin;
+                return true;
+            }
+        }
+
+        // the FIFO is done, moves on to the next priority
+        curr = tree().successor(curr);
+        enterNode();
+        return curr != NIL;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n)
+    string toString() {
+        stringstream ss;
+        toStringHelper(root, ss);
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (first == NIL) {
+            return T();
+        }
+        return front(first);
+    }
+
+    // ==operator
+    // Returns true if both trees have the same shape, priorities, and values
+    // in the same order at each priority.
+    // O(n), where n is total number of nodes in custom BST
+    bool operator==(const prcompact& other) const {
+        return compareNodes(other, root, other.root);
+    }
+};
@@ -0,0 +1,222 @@
+/// @file prheap.h
+///
+/// Array-backed binary heap engine with the same interface as prqueue.
+/// Elements live in one contiguous vector, so enqueue and dequeue do not
+/// allocate a node per element or chase pointers. Equal priorities are
+/// kept in FIFO order with a monotonically increasing sequence number.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+template<typename T>
+class prheap {
+private:
+    struct ENTRY {
+        int priority;            // used to order the heap
+        unsigned long long seq;  // insertion order, breaks priority ties
+        T value;                 // stored data for the p-queue
+    };
+    vector<ENTRY> heap;          // implicit binary heap, children of i at 2i+1, 2i+2
+    unsigned long long nextSeq;  // sequence number given to the next enqueue
+    vector<size_t> order;        // heap indices in priority order (see begin and next)
+    size_t curr;                 // position of next item in order
+
+    // returns true if a must leave the heap before b
+    static bool before(const ENTRY& a, const ENTRY& b) {
+        if (a.priority != b.priority) {
+            return a.priority < b.priority;
+        }
+        return a.seq < b.seq;
+    }
+
+    // moves the entry at index i up until its parent comes before it
+    // O(logn)
+    void siftUp(size_t i) {
+        ENTRY moving = std::move(heap[i]);
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(moving, heap[parent])) {
+                break;
+            }
+            heap[i] = std::move(heap[parent]);
+            i = parent;
+        }
+        heap[i] = std::move(moving);
+    }
+
+    // moves the entry at index i down until both children come after it
+    // O(logn)
+    void siftDown(size_t i) {
+        size_t n = heap.size();
+        ENTRY moving = std::move(heap[i]);
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) {
+                break;
+            }
+
+            // picks the child that leaves first
+            if (child + 1 < n && before(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!before(heap[child], moving)) {
+                break;
+            }
+            heap[i] = std::move(heap[child]);
+            i = child;
+        }
+        heap[i] = std::move(moving);
+    }
+
+    // returns the heap indices sorted into dequeue order
+    // O(nlogn)
+    vector<size_t> sortedOrder() const {
+        vector<size_t> idx(heap.size());
+        for (size_t i = 0; i < idx.size(); i++) {
+            idx[i] = i;
+        }
+        sort(idx.begin(), idx.end(), [this](size_t a, size_t b) {
+            return before(heap[a], heap[b]);
+        });
+        return idx;
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue.
+    // O(1)
+    prheap() {
+        nextSeq = 0;
+        curr = 0;
+    }
+
+    // clear:
+    // Removes every element from the priority queue.
+    // O(n)
+    void clear() {
+        heap.clear();
+        order.clear();
+        nextSeq = 0;
+        curr = 0;
+    }
+
+    // enqueue:
+    // Inserts the value into the heap based on priority. Values with equal
+    // priorities are dequeued in the order they were enqueued.
+    // O(logn), amortized over growth of the array
+    void enqueue(T value, int priority) {
+        heap.push_back(ENTRY{priority, nextSeq++, std::move(value)});
+        siftUp(heap.size() - 1);
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(logn)
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (heap.empty()) {
+            return T();
+        }
+
+        T valueOut = std::move(heap[0].value);
+
+        // moves the last entry to the top and sifts it into place
+        if (heap.size() > 1) {
+            heap[0] = std::move(heap.back());
+            heap.pop_back();
+            siftDown(0);
+        }
+        else {
+            heap.pop_back();
+        }
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return (int)heap.size();
+    }
+
+    // begin
+    // Resets internal state for an in-priority-order traversal. The heap is
+    // not sorted, so this takes a sorted snapshot of the entries; enqueue or
+    // dequeue invalidates it.
+    // O(nlogn)
+    void begin() {
+        order = sortedOrder();
+        curr = 0;
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1)
+    bool next(T& value, int &priority) {
+        if (curr >= order.size()) {
+            return false;
+        }
+
+        value = heap[order[curr]].value;
+        priority = heap[order[curr]].priority;
+        curr++;
+
+        return curr < order.size();
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(nlogn)
+    string toString() {
+        stringstream ss;
+        for (size_t i : sortedOrder()) {
+            ss << heap[i].priority << " value: " << heap[i].value << endl;
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (heap.empty()) {
+            return T();
+        }
+        return heap[0].value;
+    }
+
+    // ==operator
+    // Returns true if both queues hold the same values and priorities and
+    // would dequeue them in the same order.
+    // O(nlogn)
+    bool operator==(const prheap& other) const {
+        if (heap.size() != other.heap.size()) {
+            return false;
+        }
+
+        vector<size_t> a = sortedOrder();
+        vector<size_t> b = other.sortedOrder();
+        for (size_t i = 0; i < a.size(); i++) {
+            const ENTRY &x = heap[a[i]];
+            const ENTRY &y = other.heap[b[i]];
+            if (x.priority != y.priority || x.value != y.value) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
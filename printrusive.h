@@ -0,0 +1,227 @@
+/// @file printrusive.h
+///
+/// Intrusive variant of prqueue for objects that already live somewhere
+/// else, e.g. in a pool of their own. The object derives from prhook,
+/// which embeds the priority and the tree/duplicate-list links, so
+/// enqueue and dequeue never allocate and never copy the object; the
+/// queue only links and unlinks it. Ordering, the optional red-black
+/// balancing and begin/next are the same as prqueue's, and both share
+/// the tree code in rbtree.h.
+///
+/// The queue does not own its objects. An object can be in at most one
+/// queue at a time and must outlive its stay there.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include "rbtree.h"
+
+using namespace std;
+
+// hook to derive from, managed by printrusive while the object is queued
+struct prhook {
+    int priority;     // used to build BST
+    bool dup;         // marked true when there are duplicate priorities
+    prhook* parent;   // links back to parent, or previous node of a duplicate list
+    prhook* link;     // links to linked list of objects with duplicate priorities
+    prhook* tail;     // last object of the duplicate list (itself if none), BST nodes only
+    prhook* left;     // links to left child
+    prhook* right;    // links to right child
+    bool red;         // red-black color, only maintained in balanced mode
+};
+
+template<typename T>
+class printrusive {
+private:
+    static_assert(is_base_of_v<prhook, T>, "printrusive<T> needs T to derive from prhook");
+
+    prhook* root;   // pointer to root node of the BST
+    int sz;         // # of objects in the prqueue
+    prhook* curr;   // pointer to next item in prqueue (see begin and next)
+    prhook* first;  // cached leftmost node, the next item to dequeue
+    bool balanced;  // keeps the BST red-black balanced when true
+
+    // returns the object a hook is embedded in
+    static T* objectOf(prhook* node) {
+        return static_cast<T*>(node);
+    }
+
+    // helper function for toString
+    void toStringHelper(prhook* node, stringstream& ss) {
+        if (node == nullptr) {
+            return;
+        }
+
+        toStringHelper(node->left, ss);
+        for (prhook *item = node; item != nullptr; item = item->link) {
+            ss << item->priority << " value: " << *objectOf(item) << endl;
+        }
+        toStringHelper(node->right, ss);
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue. When balanced is true the BST is
+    // kept red-black balanced.
+    // O(1)
+    explicit printrusive(bool balanced = false) {
+        root = nullptr;
+        sz = 0;
+        curr = nullptr;
+        first = nullptr;
+        this->balanced = balanced;
+    }
+
+    // the queued objects belong to someone else, so it cannot be copied
+    printrusive(const printrusive&) = delete;
+    printrusive& operator=(const printrusive&) = delete;
+
+    // clear:
+    // Forgets every queued object. Nothing is freed, the objects can be
+    // enqueued again right away.
+    // O(1)
+    void clear() {
+        root = nullptr;
+        sz = 0;
+        curr = nullptr;
+        first = nullptr;
+    }
+
+    // enqueue:
+    // Links item into the BST in the correct location based on priority,
+    // after any equal priorities. item must not be in a queue already.
+    // O(logn), where n is number of unique priorities in tree
+    void enqueue(T& item, int priority) {
+        prhook *node = &item;
+        node->priority = priority;
+        node->dup = false;
+        node->parent = nullptr;
+        node->link = nullptr;
+        node->tail = node;
+        node->left = nullptr;
+        node->right = nullptr;
+        node->red = true;
+        sz++;
+
+        if (root == nullptr) {
+            root = node;
+            first = node;
+            node->red = false;
+            return;
+        }
+
+        prhook *temp = root;
+        while (true) {
+            if (priority < temp->priority) {
+                if (temp->left == nullptr) {
+                    temp->left = node;
+                    node->parent = temp;
+                    if (temp == first) {
+                        first = node;
+                    }
+                    break;
+                }
+                temp = temp->left;
+            }
+            else if (priority > temp->priority) {
+                if (temp->right == nullptr) {
+                    temp->right = node;
+                    node->parent = temp;
+                    break;
+                }
+                temp = temp->right;
+            }
+            else {
+                // joins the duplicate list, the tree shape is unchanged
+                node->red = false;
+                node->dup = true;
+                node->parent = temp->tail;
+                node->tail = nullptr;
+                temp->tail->link = node;
+                temp->tail = node;
+                temp->dup = true;
+                return;
+            }
+        }
+
+        if (balanced) {
+            chaintree<prhook>::tree(root).insertFixup(node);
+        }
+    }
+
+    // dequeue:
+    // Unlinks the next object in the priority queue and returns it, or
+    // nullptr if the queue is empty.
+    // O(1) when the minimum has no right subtree, otherwise O(logn), where n
+    // is number of unique priorities in tree
+    T* dequeue() {
+
+        // handles case where queue is empty
+        if (root == nullptr) {
+            return nullptr;
+        }
+
+        prhook *toDelete = chaintree<prhook>::unlinkFirst(root, first, balanced);
+        toDelete->parent = nullptr;
+        toDelete->link = nullptr;
+        toDelete->right = nullptr;
+        sz--;
+        return objectOf(toDelete);
+    }
+
+    // Size:
+    // Returns the # of objects in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first object in priority order.
+    // O(1)
+    void begin() {
+        curr = first;
+    }
+
+    // next
+    // Same contract as prqueue::next, but hands out the object itself:
+    // returns the next object/priority via the reference parameters, and
+    // returns false once the last one has been handed out or none are left.
+    // O(logn), where n is the number of unique priorities in tree
+    bool next(T*& item, int &priority) {
+        if (curr == nullptr) {
+            return false;
+        }
+
+        item = objectOf(curr);
+        priority = curr->priority;
+
+        curr = chaintree<prhook>::advance(curr);
+        return curr != nullptr;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order. T must
+    // support operator<<.
+    // O(n)
+    string toString() {
+        stringstream ss;
+        toStringHelper(root, ss);
+        return ss.str();
+    }
+
+    // peek:
+    // returns the next object in the priority queue but does not remove it,
+    // or nullptr if the queue is empty.
+    // O(1)
+    T* peek() {
+        if (first == nullptr) {
+            return nullptr;
+        }
+        return objectOf(first);
+    }
+};
@@ -0,0 +1,357 @@
+/// @file prpairing.h
+///
+/// Pairing heap engine with the same interface as prqueue, plus O(1) meld
+/// of two queues and decrease-key through the handle returned by enqueue.
+/// Enqueue and meld are O(1); dequeue is amortized O(logn). Equal
+/// priorities leave in the order they were enqueued, also across melded
+/// queues, using a sequence number shared by every prpairing<T>.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <cassert>
+
+using namespace std;
+
+template<typename T>
+class prpairing {
+private:
+    struct NODE {
+        int priority;            // used to order the heap
+        unsigned long long seq;  // enqueue order, breaks priority ties
+        T value;                 // stored data for the p-queue
+        NODE* child;             // links to first child
+        NODE* next;              // links to next sibling
+        NODE* prev;              // links to previous sibling, or parent for a first child
+    };
+    NODE* root;            // pointer to root of the heap, the minimum
+    int sz;                // # of elements in the prqueue
+    vector<NODE*> order;   // nodes in priority order (see begin and next)
+    size_t curr;           // position of next item in order
+
+    // shared by every queue so that melded queues stay FIFO
+    static inline atomic<unsigned long long> nextSeq{0};
+
+    // returns true if a must leave the heap before b
+    static bool before(const NODE* a, const NODE* b) {
+        if (a->priority != b->priority) {
+            return a->priority < b->priority;
+        }
+        return a->seq < b->seq;
+    }
+
+    // link:
+    // Joins two heap roots, making the later one the first child of the
+    // earlier one. Returns the new root.
+    // O(1)
+    static NODE* link(NODE* a, NODE* b) {
+        if (a == nullptr) {
+            return b;
+        }
+        if (b == nullptr) {
+            return a;
+        }
+        if (before(b, a)) {
+            swap(a, b);
+        }
+
+        b->next = a->child;
+        if (a->child != nullptr) {
+            a->child->prev = b;
+        }
+        b->prev = a;
+        a->child = b;
+        a->next = nullptr;
+        a->prev = nullptr;
+        return a;
+    }
+
+    // mergePairs:
+    // Standard two-pass pairing: links siblings in pairs left to right, then
+    // folds the results right to left. Returns the new root.
+    // Amortized O(logn)
+    static NODE* mergePairs(NODE* first) {
+        if (first == nullptr) {
+            return nullptr;
+        }
+
+        // first pass, chains the linked pairs in reverse through next
+        NODE *acc = nullptr;
+        while (first != nullptr) {
+            NODE *a = first;
+            NODE *b = a->next;
+            if (b == nullptr) {
+                a->prev = nullptr;
+                a->next = acc;
+                acc = a;
+                break;
+            }
+            first = b->next;
+            a->next = b->next = nullptr;
+            a->prev = b->prev = nullptr;
+
+            NODE *merged = link(a, b);
+            merged->next = acc;
+            acc = merged;
+        }
+
+        // second pass, folds the pairs into a single root
+        NODE *result = acc;
+        acc = acc->next;
+        result->next = nullptr;
+        while (acc != nullptr) {
+            NODE *following = acc->next;
+            acc->next = nullptr;
+            result = link(result, acc);
+            acc = following;
+        }
+        return result;
+    }
+
+    // cut:
+    // Detaches node and its subtree from its parent's child list.
+    // O(1)
+    static void cut(NODE* node) {
+        if (node->prev->child == node) {
+            node->prev->child = node->next;
+        }
+        else {
+            node->prev->next = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->prev = node->prev;
+        }
+        node->next = nullptr;
+        node->prev = nullptr;
+    }
+
+    // collects every node of the heap without recursion
+    // O(n)
+    void collect(vector<NODE*>& out) const {
+        out.clear();
+        if (root == nullptr) {
+            return;
+        }
+
+        vector<NODE*> stack;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            NODE *node = stack.back();
+            stack.pop_back();
+            out.push_back(node);
+            for (NODE *c = node->child; c != nullptr; c = c->next) {
+                stack.push_back(c);
+            }
+        }
+    }
+
+    // returns every node sorted into dequeue order
+    // O(nlogn)
+    vector<NODE*> sortedNodes() const {
+        vector<NODE*> nodes;
+        collect(nodes);
+        sort(nodes.begin(), nodes.end(), before);
+        return nodes;
+    }
+
+    // copies the nodes of other, keeping their sequence numbers
+    // O(n)
+    void copyFrom(const prpairing& other) {
+        vector<NODE*> nodes;
+        other.collect(nodes);
+        for (NODE *node : nodes) {
+            NODE *newNode = new NODE{node->priority, node->seq, node->value,
+                                     nullptr, nullptr, nullptr};
+            root = link(root, newNode);
+        }
+        sz = other.sz;
+    }
+
+public:
+    // handle to an enqueued element, valid until it is dequeued or cleared
+    using handle = NODE*;
+
+    // default constructor:
+    // Creates an empty priority queue.
+    // O(1)
+    prpairing() {
+        root = nullptr;
+        sz = 0;
+        curr = 0;
+    }
+
+    // copy constructor:
+    // Makes a deep copy of other.
+    // O(n)
+    prpairing(const prpairing& other) {
+        root = nullptr;
+        sz = 0;
+        curr = 0;
+        copyFrom(other);
+    }
+
+    // operator=
+    // Clears "this" heap and then makes a copy of the "other" heap.
+    // O(n)
+    prpairing& operator=(const prpairing& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        copyFrom(other);
+        return *this;
+    }
+
+    // clear:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    void clear() {
+        vector<NODE*> nodes;
+        collect(nodes);
+        for (NODE *node : nodes) {
+            delete node;
+        }
+        root = nullptr;
+        sz = 0;
+        order.clear();
+        curr = 0;
+    }
+
+    // destructor:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    ~prpairing() {
+        clear();
+    }
+
+    // enqueue:
+    // Links a new single-node heap with the root. Returns a handle that can
+    // be passed to decreaseKey.
+    // O(1)
+    handle enqueue(T value, int priority) {
+        NODE *newNode = new NODE{priority, nextSeq.fetch_add(1, memory_order_relaxed),
+                                 std::move(value), nullptr, nullptr, nullptr};
+        root = link(root, newNode);
+        sz++;
+        return newNode;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // Amortized O(logn)
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (root == nullptr) {
+            return T();
+        }
+
+        NODE *toDelete = root;
+        T valueOut = std::move(toDelete->value);
+        root = mergePairs(toDelete->child);
+        delete toDelete;
+        sz--;
+
+        return valueOut;
+    }
+
+    // meld:
+    // Moves every element of other into this queue without copying, leaving
+    // other empty. Handles into other now refer to elements of this queue.
+    // A begin/next traversal of either queue ends here.
+    // O(1), plus dropping the traversal snapshots
+    void meld(prpairing& other) {
+        if (this == &other) {
+            return;
+        }
+
+        root = link(root, other.root);
+        sz += other.sz;
+        other.root = nullptr;
+        other.sz = 0;
+
+        // the snapshots no longer match what either queue holds
+        order.clear();
+        curr = 0;
+        other.order.clear();
+        other.curr = 0;
+    }
+
+    // decreaseKey:
+    // Lowers the priority of the element behind h, which must still be in
+    // this queue. Among equal priorities it keeps its original enqueue order.
+    // O(1), amortized O(logn) charged to the following dequeue
+    void decreaseKey(handle h, int priority) {
+        assert(priority <= h->priority && "decreaseKey cannot raise a priority");
+        h->priority = priority;
+
+        // the root stays the root, anything else is cut and relinked
+        if (h != root) {
+            cut(h);
+            root = link(root, h);
+        }
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an in-priority-order traversal from a sorted
+    // snapshot; enqueue, dequeue, decreaseKey or a meld into or out of this
+    // queue invalidates it.
+    // O(nlogn)
+    void begin() {
+        order = sortedNodes();
+        curr = 0;
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1)
+    bool next(T& value, int &priority) {
+        if (curr >= order.size()) {
+            return false;
+        }
+
+        value = order[curr]->value;
+        priority = order[curr]->priority;
+        curr++;
+
+        return curr < order.size();
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(nlogn)
+    string toString() {
+        stringstream ss;
+        for (NODE *node : sortedNodes()) {
+            ss << node->priority << " value: " << node->value << endl;
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (root == nullptr) {
+            return T();
+        }
+        return root->value;
+    }
+};
@@ -11,10 +11,20 @@
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <memory>
+#include <memory_resource>
+#include "nodepool.h"
+#include "rbtree.h"
 
 using namespace std;
 
-template<typename T>
+// Allocator supplies the slabs that NODEs are carved from; see nodepool.h.
+template<typename T, typename Allocator = allocator<T>>
 class prqueue {
 private:
     struct NODE {
@@ -23,22 +33,718 @@ private:
         bool dup;      // marked true when there are duplicate priorities
         NODE* parent;  // links back to parent
         NODE* link;    // links to linked list of NODES with duplicate priorities
+        NODE* tail;    // last NODE of the duplicate list (itself if none), BST nodes only
         NODE* left;    // links to left child
         NODE* right;   // links to right child
+        bool red;      // red-black color, only maintained in balanced mode
+
+        // builds a lone red node, constructing value in place from args
+        template<typename... Args>
+        explicit NODE(int priority, Args&&... args)
+            : priority(priority), value(std::forward<Args>(args)...) {
+            dup = false;
+            parent = nullptr;
+            link = nullptr;
+            tail = this;
+            left = nullptr;
+            right = nullptr;
+            red = true;
+        }
+    };
+    NODE* root;    // pointer to root node of the BST
+    int sz;        // # of elements in the prqueue
+    NODE* curr;    // pointer to next item in prqueue (see begin and next)
+    NODE* first;   // cached leftmost node, the next item to dequeue
+    bool balanced; // keeps the BST red-black balanced when true
+    int depthBound; // upper bound on the # of BST levels, kept for the default mode
+    nodepool<NODE, Allocator> pool; // slabs that every NODE is allocated from
+
+    // allocates a NODE from the pool, reusing freed storage when possible,
+    // and constructs its value from args
+    // O(1)
+    template<typename... Args>
+    NODE* newNode(int priority, Args&&... args) {
+        return new (pool.allocate()) NODE(priority, std::forward<Args>(args)...);
+    }
+
+    // destroys a NODE and returns its storage to the pool
+    // O(1)
+    void freeNode(NODE* node) {
+        node->~NODE();
+        pool.deallocate(node);
+    }
+
+    // returns true if node is black, null leaves count as black
+    static bool isBlack(NODE* node) {
+        return node == nullptr || !node->red;
+    }
+
+    // returns the red-black balancing code for this queue's BST
+    rbtree<pointerLinks<NODE>> tree() {
+        return chaintree<NODE>::tree(root);
+    }
+
+    // insertNode:
+    // Links a lone newNode into the BST, searching down from the root.
+    // O(logn), where n is number of unique nodes in tree
+    void insertNode(NODE* newNode) {
+
+        // increments the size of the priority queue
+        sz++;
+
+        // if tree is empty, the new node is the root
+        if (root == nullptr) {
+            root = newNode;
+            first = newNode;
+            newNode->parent = nullptr;
+            newNode->red = false;
+            depthBound = 1;
+            return;
+        }
+
+        // loops to find proper spot for node, counting its depth
+        NODE *temp = root;
+        int depth = 1;
+        while (true) {
+
+            // checks if new node's priority is less
+            if (newNode->priority < temp->priority) {
+
+                // if there is no left child, the new node becomes the left child 
+                if (temp->left == nullptr) {
+                    temp->left = newNode;
+                    newNode->parent = temp;
+
+                    // a new left child of the leftmost node is the new minimum
+                    if (temp == first) {
+                        first = newNode;
+                    }
+                    depthBound = max(depthBound, depth + 1);
+                    if (balanced) {
+                        tree().insertFixup(newNode);
+                    }
+                    return;
+                }
+
+                // moves to left child
+                temp = temp->left;
+                depth++;
+            }
+
+            // checks if new node's priority is more
+            else if (newNode->priority > temp->priority) {
+
+                // if there is no right child, the new node becomes the right child
+                if (temp->right == nullptr) {
+                    temp->right = newNode;
+                    newNode->parent = temp;
+                    depthBound = max(depthBound, depth + 1);
+                    if (balanced) {
+                        tree().insertFixup(newNode);
+                    }
+                    return;
+                }
+
+                // moves to right child
+                temp = temp->right;
+                depth++;
+            }
+
+            // if priorities are equal, the node only joins the
+            // duplicate list so the tree shape does not change
+            else {
+                newNode->red = false;
+
+                // links new node after the cached last node of the list,
+                // sets the parent of the node and marks both as duplicates
+                NODE *tempLink = temp->tail;
+                tempLink->link = newNode;
+                newNode->parent = tempLink;
+                newNode->dup = true;
+                temp->dup = true;
+                temp->tail = newNode;
+                return;
+            }
+        }
+    }
+
+    // unlinkFirst:
+    // Unlinks the minimum node, the cached first, by pointer relinking and
+    // returns it without touching its value. The queue must not be empty.
+    // O(1) when the minimum has no right subtree, otherwise O(logn), where n
+    // is number of unique nodes in tree; a run of k calls walks the tree
+    // in order once, O(logn + k) amortized
+    NODE* unlinkFirst() {
+        NODE *toDelete = chaintree<NODE>::unlinkFirst(root, first, balanced);
+        sz--;
+        return toDelete;
+    }
+
+    // detach:
+    // Unlinks node from the BST or its duplicate list by pointer relinking,
+    // leaving its value alone. Works for any node, unlike unlinkFirst.
+    // O(logn), where n is number of unique nodes in tree
+    void detach(NODE* node) {
+        sz--;
+
+        // a duplicate list member is the link of the node before it
+        if (node->parent != nullptr && node->parent->link == node) {
+            NODE *prev = node->parent;
+            prev->link = node->link;
+            if (node->link != nullptr) {
+                node->link->parent = prev;
+                return;
+            }
+
+            // the last one, finds the list's BST node to fix its tail
+            NODE *head = root;
+            while (head->priority != node->priority) {
+                head = (node->priority < head->priority) ? head->left : head->right;
+            }
+            head->tail = prev;
+            head->dup = (head->link != nullptr);
+            return;
+        }
+
+        // a BST node with duplicates, the first one takes its place
+        if (node->link != nullptr) {
+            NODE *heir = node->link;
+            heir->parent = node->parent;
+            heir->left = node->left;
+            heir->right = node->right;
+            heir->red = node->red;
+            heir->tail = (node->tail == heir) ? heir : node->tail;
+            heir->dup = (heir->link != nullptr);
+            if (heir->left != nullptr) {
+                heir->left->parent = heir;
+            }
+            if (heir->right != nullptr) {
+                heir->right->parent = heir;
+            }
+            tree().replaceChild(node->parent, node, heir);
+            if (first == node) {
+                first = heir;
+            }
+            return;
+        }
+
+        // a lone BST node, unlinked like a standard red-black delete: a node
+        // with two children trades places with its successor first
+        bool wasFirst = (node == first);
+        bool removedRed = node->red;
+        NODE *child;
+        NODE *parent;
+        if (node->left == nullptr || node->right == nullptr) {
+            child = (node->left != nullptr) ? node->left : node->right;
+            parent = node->parent;
+            tree().replaceChild(parent, node, child);
+            if (child != nullptr) {
+                child->parent = parent;
+            }
+        }
+        else {
+            NODE *suc = node->right;
+            while (suc->left != nullptr) {
+                suc = suc->left;
+            }
+            removedRed = suc->red;
+            child = suc->right;
+
+            // the successor leaves its spot, unless it is right below node
+            if (suc->parent == node) {
+                parent = suc;
+            }
+            else {
+                parent = suc->parent;
+                parent->left = child;
+                if (child != nullptr) {
+                    child->parent = parent;
+                }
+                suc->right = node->right;
+                suc->right->parent = suc;
+            }
+
+            // the successor takes over node's spot and color
+            suc->parent = node->parent;
+            tree().replaceChild(node->parent, node, suc);
+            suc->left = node->left;
+            suc->left->parent = suc;
+            suc->red = node->red;
+        }
+
+        if (balanced && !removedRed) {
+            tree().eraseFixup(child, parent);
+        }
+
+        // the minimum has no left child, so the new one is below or above it
+        if (wasFirst) {
+            first = root;
+            if (first != nullptr) {
+                while (first->left != nullptr) {
+                    first = first->left;
+                }
+            }
+        }
+    }
+
+    // chainRuns:
+    // Chains each run of equal priorities in sorted, lone nodes in priority
+    // order, behind the run's first node and returns those first nodes.
+    // O(k), where k is the # of nodes in sorted
+    static vector<NODE*> chainRuns(const vector<NODE*>& sorted) {
+        vector<NODE*> heads;
+        for (NODE *node : sorted) {
+            if (!heads.empty() && heads.back()->priority == node->priority) {
+                NODE *head = heads.back();
+                node->red = false;
+                node->dup = true;
+                node->parent = head->tail;
+                node->tail = nullptr;
+                head->tail->link = node;
+                head->tail = node;
+                head->dup = true;
+            }
+            else {
+                heads.push_back(node);
+            }
+        }
+        return heads;
+    }
+
+    // linkBalanced:
+    // Links the sorted BST nodes in heads into a perfectly balanced,
+    // red-black valid tree and returns its root.
+    // O(k), where k is the # of nodes in heads
+    NODE* linkBalanced(vector<NODE*>& heads) {
+
+        // the deepest level of a tree built by halving has depth floor(log2 k)
+        int redDepth = levelsFor(heads.size()) - 1;
+        return buildBalanced(heads, 0, heads.size(), nullptr, 0, redDepth);
+    }
+
+    // returns the # of levels of a perfectly balanced tree of k nodes,
+    // floor(log2 k) + 1, or 0 for none
+    // O(logk)
+    static int levelsFor(size_t k) {
+        int levels = 0;
+        while (((size_t)1 << levels) <= k) {
+            levels++;
+        }
+        return levels;
+    }
+
+    // returns an upper bound on the # of BST levels: the tracked one in the
+    // default mode, the red-black bound of 2 log2(n + 1) in balanced mode
+    // O(logn)
+    int heightBound() const {
+        return balanced ? 2 * levelsFor(sz) : depthBound;
+    }
+
+    // returns true if the BST may be deeper than 2 log2(n + 1), which only
+    // happens in the default mode, e.g. after sorted enqueues, and would
+    // make the split and union recursion of merge deeper than O(logn)
+    // O(logn)
+    bool tooDeep() const {
+        return heightBound() > 2 * levelsFor(sz);
+    }
+
+    // a detached subtree and its black height, the # of black nodes on
+    // every path from its root down to a null leaf
+    struct SUBTREE {
+        NODE* root;
+        int blackHeight;
     };
-    NODE* root; // pointer to root node of the BST
-    int sz;     // # of elements in the prqueue
-    NODE* curr; // pointer to next item in prqueue (see begin and next)
+
+    // returns the subtree below child, cut loose from its parent
+    static SUBTREE detachChild(NODE* child, int blackHeight) {
+        if (child != nullptr) {
+            child->parent = nullptr;
+        }
+        return SUBTREE{child, blackHeight};
+    }
+
+    // makes mid the parentless root over left and right
+    static void attach(NODE* left, NODE* mid, NODE* right) {
+        mid->left = left;
+        mid->right = right;
+        mid->parent = nullptr;
+        if (left != nullptr) {
+            left->parent = mid;
+        }
+        if (right != nullptr) {
+            right->parent = mid;
+        }
+    }
+
+    // joinRight:
+    // Hangs mid with right below it into the right spine of left, which is
+    // black-higher, at the first black node of right's black height. The
+    // result has left's black height but may be a red root with a red
+    // right child, which joinTrees fixes.
+    // O(left.blackHeight - right.blackHeight)
+    NODE* joinRight(SUBTREE left, NODE* mid, SUBTREE right) {
+        if (left.blackHeight == right.blackHeight && isBlack(left.root)) {
+            attach(left.root, mid, right.root);
+            mid->red = true;
+            return mid;
+        }
+
+        NODE *top = left.root;
+        int childHeight = left.blackHeight - (top->red ? 0 : 1);
+        NODE *joined = joinRight(SUBTREE{top->right, childHeight}, mid, right);
+        top->right = joined;
+        joined->parent = top;
+
+        // two reds in a row below a black node, rotate them up
+        if (!top->red && joined->red && !isBlack(joined->right)) {
+            joined->right->red = false;
+            top->right = joined->left;
+            if (top->right != nullptr) {
+                top->right->parent = top;
+            }
+            joined->left = top;
+            top->parent = joined;
+            joined->parent = nullptr;
+            return joined;
+        }
+        return top;
+    }
+
+    // joinLeft:
+    // Mirror image of joinRight, for a black-higher right.
+    // O(right.blackHeight - left.blackHeight)
+    NODE* joinLeft(SUBTREE left, NODE* mid, SUBTREE right) {
+        if (left.blackHeight == right.blackHeight && isBlack(right.root)) {
+            attach(left.root, mid, right.root);
+            mid->red = true;
+            return mid;
+        }
+
+        NODE *top = right.root;
+        int childHeight = right.blackHeight - (top->red ? 0 : 1);
+        NODE *joined = joinLeft(left, mid, SUBTREE{top->left, childHeight});
+        top->left = joined;
+        joined->parent = top;
+
+        // two reds in a row below a black node, rotate them up
+        if (!top->red && joined->red && !isBlack(joined->left)) {
+            joined->left->red = false;
+            top->left = joined->right;
+            if (top->left != nullptr) {
+                top->left->parent = top;
+            }
+            joined->right = top;
+            top->parent = joined;
+            joined->parent = nullptr;
+            return joined;
+        }
+        return top;
+    }
+
+    // joinTrees:
+    // Joins left, mid and right, where every priority in left is below
+    // mid's and every one in right above it, into one tree. In balanced
+    // mode the shorter side is hung into the taller one and the result is
+    // a red-black tree; otherwise mid simply becomes the root.
+    // O(|left.blackHeight - right.blackHeight| + 1)
+    SUBTREE joinTrees(SUBTREE left, NODE* mid, SUBTREE right) {
+        if (!balanced) {
+            attach(left.root, mid, right.root);
+            mid->red = false;
+            return SUBTREE{mid, 0};
+        }
+
+        // a red root can always turn black, so both sides start black
+        if (!isBlack(left.root)) {
+            left.root->red = false;
+            left.blackHeight++;
+        }
+        if (!isBlack(right.root)) {
+            right.root->red = false;
+            right.blackHeight++;
+        }
+
+        if (left.blackHeight > right.blackHeight) {
+            NODE *joined = joinRight(left, mid, right);
+            if (joined->red && !isBlack(joined->right)) {
+                joined->red = false;
+                return SUBTREE{joined, left.blackHeight + 1};
+            }
+            return SUBTREE{joined, left.blackHeight};
+        }
+        if (right.blackHeight > left.blackHeight) {
+            NODE *joined = joinLeft(left, mid, right);
+            if (joined->red && !isBlack(joined->left)) {
+                joined->red = false;
+                return SUBTREE{joined, right.blackHeight + 1};
+            }
+            return SUBTREE{joined, right.blackHeight};
+        }
+
+        attach(left.root, mid, right.root);
+        mid->red = true;
+        return SUBTREE{mid, left.blackHeight};
+    }
+
+    // splitTree:
+    // Splits tree into the priorities below priority (less), the BST node
+    // holding priority if there is one (equal), and those above (greater).
+    // O(logn), where n is number of unique nodes in tree
+    void splitTree(SUBTREE tree, int priority, SUBTREE& less, NODE*& equal, SUBTREE& greater) {
+        if (tree.root == nullptr) {
+            less = SUBTREE{nullptr, 0};
+            greater = SUBTREE{nullptr, 0};
+            equal = nullptr;
+            return;
+        }
+
+        NODE *top = tree.root;
+        int childHeight = tree.blackHeight - (top->red ? 0 : 1);
+        SUBTREE left = detachChild(top->left, childHeight);
+        SUBTREE right = detachChild(top->right, childHeight);
+
+        if (priority == top->priority) {
+            less = left;
+            equal = top;
+            greater = right;
+        }
+        else if (priority < top->priority) {
+            SUBTREE middle;
+            splitTree(left, priority, less, equal, middle);
+            greater = joinTrees(middle, top, right);
+        }
+        else {
+            SUBTREE middle;
+            splitTree(right, priority, middle, equal, greater);
+            less = joinTrees(left, top, middle);
+        }
+    }
+
+    // appends the duplicate list of extra, a BST node of the same priority
+    // taken out of another tree, to the list of base, so that extra and its
+    // duplicates leave after everything already at base
+    // O(1)
+    static void appendChain(NODE* base, NODE* extra) {
+        NODE *extraTail = extra->tail;
+        base->tail->link = extra;
+        extra->parent = base->tail;
+        extra->left = nullptr;
+        extra->right = nullptr;
+        extra->tail = nullptr;
+        extra->red = false;
+        extra->dup = true;
+        base->tail = extraTail;
+        base->dup = true;
+    }
+
+    // unionTrees:
+    // Join-based union: splits other by the root priority of mine, unions
+    // the halves on each side, and joins them back under that root. Equal
+    // priorities from other go behind those of mine.
+    // O(m log(n/m + 1)) in balanced mode, where m and n are the # of unique
+    // nodes in the smaller and larger tree
+    SUBTREE unionTrees(SUBTREE mine, SUBTREE other) {
+        if (mine.root == nullptr) {
+            return other;
+        }
+        if (other.root == nullptr) {
+            return mine;
+        }
+
+        NODE *top = mine.root;
+        int childHeight = mine.blackHeight - (top->red ? 0 : 1);
+        SUBTREE left = detachChild(top->left, childHeight);
+        SUBTREE right = detachChild(top->right, childHeight);
+
+        SUBTREE otherLess, otherGreater;
+        NODE *equal;
+        splitTree(other, top->priority, otherLess, equal, otherGreater);
+        if (equal != nullptr) {
+            appendChain(top, equal);
+        }
+
+        SUBTREE joinedLeft = unionTrees(left, otherLess);
+        SUBTREE joinedRight = unionTrees(right, otherGreater);
+        return joinTrees(joinedLeft, top, joinedRight);
+    }
+
+    // returns the black height of a valid red-black tree
+    // O(logn), where n is number of unique nodes in tree
+    static int blackHeightOf(NODE* node) {
+        int height = 0;
+        for (; node != nullptr; node = node->left) {
+            if (!node->red) {
+                height++;
+            }
+        }
+        return height;
+    }
+
+    // rebuilds the BST as a perfectly balanced, red-black valid tree
+    // O(n), where n is number of unique nodes in tree
+    void rebuildBalanced() {
+        vector<NODE*> heads;
+        vector<NODE*> stack;
+        NODE *node = root;
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                stack.push_back(node);
+                node = node->left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            heads.push_back(node);
+            node = node->right;
+        }
+        root = linkBalanced(heads);
+        first = heads.empty() ? nullptr : heads.front();
+        depthBound = levelsFor(heads.size());
+    }
+
+    // buildBalanced:
+    // Links the BST nodes heads[lo, hi), sorted by priority, into a
+    // perfectly balanced subtree under parent and returns its root. Only
+    // nodes on the deepest level (depth == redDepth) are red, which keeps
+    // every path to a leaf at the same black height.
+    // O(hi - lo)
+    NODE* buildBalanced(vector<NODE*>& heads, size_t lo, size_t hi,
+                        NODE* parent, int depth, int redDepth) {
+        if (lo >= hi) {
+            return nullptr;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        NODE *node = heads[mid];
+        node->parent = parent;
+        node->red = (depth == redDepth && depth > 0);
+        node->left = buildBalanced(heads, lo, mid, node, depth + 1, redDepth);
+        node->right = buildBalanced(heads, mid + 1, hi, node, depth + 1, redDepth);
+        return node;
+    }
+
+    // unionIn:
+    // Unions the BST rooted at otherRoot, whose nodes this queue already
+    // owns, into this one; equal priorities from it go behind this queue's.
+    // otherRoot must be at most otherLevels deep, and in balanced mode a
+    // valid red-black tree. In the default mode this tree is first relinked
+    // into balanced shape if it has grown too deep for the split and union
+    // recursion. sz is left to the caller.
+    // O(m log(n/m + 1)) in balanced mode, where m and n are the # of unique
+    // priorities in the smaller and larger tree; O(m logn logm) in the
+    // default mode, plus O(n) when this tree has to be relinked
+    void unionIn(NODE* otherRoot, int otherLevels) {
+        if (tooDeep()) {
+            rebuildBalanced();
+        }
+
+        SUBTREE mine{root, balanced ? blackHeightOf(root) : 0};
+        SUBTREE theirs{otherRoot, balanced ? blackHeightOf(otherRoot) : 0};
+        root = unionTrees(mine, theirs).root;
+        root->parent = nullptr;
+        if (balanced) {
+            root->red = false;
+        }
+
+        // each level of the result comes from one tree or the other
+        depthBound += otherLevels;
+
+        first = root;
+        while (first->left != nullptr) {
+            first = first->left;
+        }
+    }
     
 public:
 
+    // handle to an enqueued element, valid until it is dequeued, erased or
+    // cleared
+    using handle = NODE*;
+
     // default constructor:
     // Creates an empty priority queue.
     // O(1)    
-    prqueue() {
+    prqueue() : prqueue(false, Allocator()) {
+    }
+
+    // balanced constructor:
+    // Creates an empty priority queue. When balanced is true the BST is
+    // kept red-black balanced, so enqueue and dequeue stay O(logn) even for
+    // sorted or adversarial priorities.
+    // O(1)
+    explicit prqueue(bool balanced) : prqueue(balanced, Allocator()) {
+    }
+
+    // allocator constructor:
+    // Creates an empty priority queue whose nodes are allocated through
+    // alloc, e.g. a pmr::polymorphic_allocator over a monotonic arena.
+    // O(1)
+    explicit prqueue(const Allocator& alloc) : prqueue(false, alloc) {
+    }
+
+    // memory resource constructor:
+    // Shorthand for pmr queues, e.g. pmr_prqueue<int> pq(&arena). Without
+    // it the pointer would silently convert to the balanced flag.
+    // O(1)
+    explicit prqueue(pmr::memory_resource* resource)
+        requires is_constructible_v<Allocator, pmr::memory_resource*>
+        : prqueue(false, Allocator(resource)) {
+    }
+
+    // balanced allocator constructor:
+    // Combination of the two constructors above.
+    // O(1)
+    prqueue(bool balanced, const Allocator& alloc) : pool(alloc) {
         root = nullptr;
         sz = 0;
         curr = nullptr;
+        first = nullptr;
+        this->balanced = balanced;
+        depthBound = 0;
+    }
+
+    // copy constructor:
+    // Makes a copy of the "other" tree in a pool of its own.
+    // O(n), where n is total number of nodes in custom BST
+    prqueue(const prqueue& other)
+        : prqueue(other.balanced,
+                  allocator_traits<Allocator>::select_on_container_copy_construction(
+                      other.get_allocator())) {
+        *this = other;
+    }
+
+    // move constructor:
+    // Takes over the tree and the node pool of other, which is left empty.
+    // Nothing is copied or allocated and handles into other now refer to
+    // this queue.
+    // O(1)
+    prqueue(prqueue&& other) noexcept : pool(std::move(other.pool)) {
+        root = other.root;
+        sz = other.sz;
+        curr = other.curr;
+        first = other.first;
+        balanced = other.balanced;
+        depthBound = other.depthBound;
+        other.root = nullptr;
+        other.sz = 0;
+        other.curr = nullptr;
+        other.first = nullptr;
+    }
+
+    // range constructor:
+    // Builds a queue from a range of (value, priority) pairs, e.g. a
+    // vector<pair<T, int>>. Equal priorities keep the order of the range.
+    // See assign.
+    // O(n logn), O(n) if the range is already sorted by priority
+    template<input_iterator InputIt>
+    prqueue(InputIt from, InputIt to, bool balanced = false,
+            const Allocator& alloc = Allocator())
+        : prqueue(balanced, alloc) {
+        assign(from, to);
+    }
+
+    // returns a copy of the allocator used for the nodes
+    Allocator get_allocator() const {
+        return pool.get_allocator();
     }
 
     // operator=
@@ -56,60 +762,136 @@ public:
 
         // copies the root node of other prqueue
         // and assigns it to root of this prqueue
-        root = copy(other.root);
+        root = copy(other.root, nullptr);
 
-        // makes other prqueue and this prqueue have same size
+        // makes other prqueue and this prqueue have same size and mode
         sz = other.sz;
+        balanced = other.balanced;
+        depthBound = other.depthBound;
+
+        // finds the leftmost node of the copied tree
+        first = root;
+        if (first != nullptr) {
+            while (first->left != nullptr) {
+                first = first->left;
+            }
+        }
 
         return *this;
     }
 
+    // move assignment:
+    // Clears "this" tree and takes over the tree and the node pool of
+    // other, which is left empty. Handles into other now refer to this
+    // queue. If the allocators neither propagate nor compare equal, the
+    // nodes cannot change owner and the elements are moved over one by one
+    // instead, see merge.
+    // O(n) to clear this queue, plus O(m log m) for unequal allocators,
+    // where m is the # of elements in other
+    prqueue& operator=(prqueue&& other)
+        noexcept(allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+              || allocator_traits<Allocator>::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        balanced = other.balanced;
+        curr = nullptr;
+
+        if constexpr (!allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+                   && !allocator_traits<Allocator>::is_always_equal::value) {
+            if (!(get_allocator() == other.get_allocator())) {
+                merge(std::move(other));
+                return *this;
+            }
+        }
+
+        pool = std::move(other.pool);
+        root = other.root;
+        sz = other.sz;
+        first = other.first;
+        depthBound = other.depthBound;
+        other.root = nullptr;
+        other.sz = 0;
+        other.curr = nullptr;
+        other.first = nullptr;
+        return *this;
+    }
+
+    // assign:
+    // Replaces the contents with a range of (value, priority) pairs. All
+    // nodes are created up front, stably sorted by priority (skipped when
+    // the range is already sorted), chained into duplicate lists, and
+    // linked into a perfectly balanced tree that is also a valid
+    // red-black tree. Much faster than enqueueing the range one by one,
+    // which degenerates for sorted input in unbalanced mode.
+    // O(n logn), O(n) if the range is already sorted by priority
+    template<input_iterator InputIt>
+    void assign(InputIt from, InputIt to) {
+        clear();
+        if constexpr (forward_iterator<InputIt>) {
+            pool.reserve(distance(from, to));
+        }
+
+        // creates a lone node for every element, in range order
+        vector<NODE*> all;
+        for (; from != to; ++from) {
+            auto&& item = *from;
+            all.push_back(newNode(item.second, std::forward<decltype(item)>(item).first));
+        }
+        if (all.empty()) {
+            return;
+        }
+
+        auto byPriority = [](const NODE* a, const NODE* b) {
+            return a->priority < b->priority;
+        };
+        if (!is_sorted(all.begin(), all.end(), byPriority)) {
+            stable_sort(all.begin(), all.end(), byPriority);
+        }
+
+        // chains each run of equal priorities behind its first node
+        vector<NODE*> heads = chainRuns(all);
+        root = linkBalanced(heads);
+        first = heads.front();
+        depthBound = levelsFor(heads.size());
+        sz = (int)all.size();
+    }
+
     // helper function for operator=
-    // creates a copy of a NODE and its children
+    // creates a copy of a NODE and its children, hanging it under parent
     // returns the copy node
-    NODE* copy(NODE* node) {
+    NODE* copy(NODE* node, NODE* parent) {
         // handles base case
         if (node == nullptr) {
             return nullptr;
         }
 
         // creates a new node and copies the values from input node
-        NODE *newNode = new NODE;
-        newNode->priority = node->priority;
-        newNode->value = node->value;
+        NODE *newNode = this->newNode(node->priority, node->value);
         newNode->dup = node->dup;
-        newNode->parent = nullptr;
+        newNode->red = node->red;
+        newNode->parent = parent;
+        newNode->tail = newNode;
 
         // recursively copies the left and right children of the node
-        newNode->left = copy(node->left);
-        newNode->right = copy(node->right);
+        newNode->left = copy(node->left, newNode);
+        newNode->right = copy(node->right, newNode);
 
         // handles duplicates with the same priority
-        if (node->link != nullptr) {
-            newNode->link = new NODE;
-            NODE *newLink = newNode->link;
-            NODE *oldLink = node->link;
-
-            // goes through linked nodes and copies the values
-            while (oldLink != nullptr) {
-                newLink->priority = oldLink->priority;
-                newLink->value = oldLink->value;
-                newLink->dup = oldLink->dup;
-                newLink->parent = nullptr;
-                newLink->left = nullptr;
-                newLink->right = nullptr;
-
-                // checks if there is another node to link, allocates a new node if that is true
-                newLink->link = (oldLink->link != nullptr) ? new NODE : nullptr;
-
-                // moves to the next linked node
-                oldLink = oldLink->link;
-                newLink = newLink->link;
-            }
-        }
-        // sets link to nullptr if there is not a linked node
-        else {
-            newNode->link = nullptr;
+        NODE *prevLink = newNode;
+        for (NODE *oldLink = node->link; oldLink != nullptr; oldLink = oldLink->link) {
+
+            // copies the linked node and appends it to the new list
+            NODE *newLink = this->newNode(oldLink->priority, oldLink->value);
+            newLink->dup = oldLink->dup;
+            newLink->red = false;
+            newLink->parent = prevLink;
+            newLink->tail = nullptr;
+            prevLink->link = newLink;
+            newNode->tail = newLink;
+            prevLink = newLink;
         }
 
         // returns copied node
@@ -117,6 +899,7 @@ public:
     }
 
     // helper function for the clear function
+    // destroys every NODE, the pool then frees their storage in one go
     void clearHelper(NODE* node) {
 
         // handles base case
@@ -132,22 +915,30 @@ public:
         while (temp != nullptr) {
             NODE *toDelete = temp;
             temp = temp->link;
-            delete toDelete;
+            toDelete->~NODE();
         }
 
-        // frees the memory from the node
-        delete node;
+        // destroys the node, its memory goes back with the slab
+        node->~NODE();
     }
 
     // clear:
     // Frees the memory associated with the priority queue but is public.
-    // O(n), where n is total number of nodes in custom BST
+    // Values that need no destructor are not visited at all, the pool just
+    // releases its slabs.
+    // O(n), where n is total number of nodes in custom BST, or O(s) for
+    // trivially destructible T, where s is the number of slabs
     void clear() {
         
         // clears the BST, sets the root to a nullptr, and updates the size
-        clearHelper(root);
+        if constexpr (!is_trivially_destructible_v<T>) {
+            clearHelper(root);
+        }
+        pool.release();
         root = nullptr;
+        first = nullptr;
         sz = 0;
+        depthBound = 0;
     }
 
     // destructor:
@@ -157,97 +948,212 @@ public:
         clear();
     }
     
-    // enqueue:
-    // Inserts the value into the custom BST in the correct location based on
-    // priority.
-    // O(logn + m), where n is number of unique nodes in tree and m is number 
-    // of duplicate priorities
-    void enqueue(T value, int priority) {
-        
-        // creates new node and sets initial values for it
-        NODE *newNode = new NODE;
-        newNode->value = value;
-        newNode->priority = priority;
-        newNode->left = nullptr;
-        newNode->right = nullptr;
-        newNode->link = nullptr;
-        newNode->dup = false;
+    // enqueue_batch:
+    // Enqueues every (value, priority) pair of batch, moving the values out
+    // of it. Equal priorities keep batch order, after any already queued.
+    // The nodes are all allocated up front and ordered by a natural merge
+    // sort: runs that are already sorted are detected and merged pairwise,
+    // so a sorted batch is not sorted at all. They are then linked into a
+    // balanced tree of their own, like assign does, and joined into the
+    // queue with the union that merge uses, so a batch touches only the
+    // parts of the tree its priorities fall into.
+    // O(k logr) to sort, where k is the batch size and r the # of sorted
+    // runs in it, plus the union: O(u log(n/u + 1)) in balanced mode, where
+    // u and n are the # of unique priorities in the smaller and larger of
+    // batch and queue; O(k logn logk) in the default mode, plus O(n) when the
+    // queue has grown too deep and is relinked first, see merge
+    void enqueue_batch(span<pair<T, int>> batch) {
+        if (batch.empty()) {
+            return;
+        }
+        pool.reserve(batch.size());
+
+        // creates the nodes and records where each sorted run starts
+        vector<NODE*> nodes;
+        vector<size_t> runs;
+        nodes.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (i == 0 || batch[i].second < batch[i - 1].second) {
+                runs.push_back(i);
+            }
+            nodes.push_back(newNode(batch[i].second, std::move(batch[i].first)));
+        }
+        runs.push_back(nodes.size());
+
+        // merges neighbouring runs until one is left, stable for equal ones
+        auto byPriority = [](const NODE* a, const NODE* b) {
+            return a->priority < b->priority;
+        };
+        while (runs.size() > 2) {
+            vector<size_t> merged;
+            size_t r = 0;
+            for (; r + 2 < runs.size(); r += 2) {
+                inplace_merge(nodes.begin() + runs[r], nodes.begin() + runs[r + 1],
+                              nodes.begin() + runs[r + 2], byPriority);
+                merged.push_back(runs[r]);
+            }
+            if (r + 1 < runs.size()) {
+                merged.push_back(runs[r]);
+            }
+            merged.push_back(nodes.size());
+            runs.swap(merged);
+        }
 
-        // if tree is empty, the new node is the root
-        if (root == nullptr) {
-            root = newNode;
-            newNode->parent = nullptr;
+        // links the sorted batch into a tree and joins it in
+        vector<NODE*> heads = chainRuns(nodes);
+        unionIn(linkBalanced(heads), levelsFor(heads.size()));
+        sz += (int)nodes.size();
+    }
+
+    // merge:
+    // Moves every element of other into this queue and leaves other empty.
+    // At equal priorities, other's elements go after this queue's, in their
+    // own order. The trees are combined by a join-based union that relinks
+    // other's nodes, so nothing is allocated or copied, and this queue's
+    // pool takes over other's slabs. Handles into other now refer to
+    // elements of this queue. The default mode has no depth bound, so a
+    // tree that has grown deeper than 2 log2(n + 1), e.g. from sorted
+    // enqueues, is first relinked into balanced shape to keep the split and
+    // union recursion shallow.
+    // If the allocators differ, other's nodes cannot change owner: its
+    // elements are moved into new nodes one by one instead, and handles
+    // into other are invalidated.
+    // O(m log(n/m + 1)) in balanced mode, where m and n are the # of unique
+    // priorities in the smaller and larger queue, plus the # of free nodes
+    // in other's pool. O(m logn logm) in the default mode, plus O(m) to
+    // relink a too deep other and O(n) for this queue; a relink leaves this
+    // queue about log2(n + 1) deep, so it recurs only after enqueues and
+    // merges have added that many levels again, amortized O(n / logn) per
+    // level. O(m log n), m being the # of elements in other, when the
+    // allocators differ
+    void merge(prqueue&& other) {
+        if (this == &other || other.root == nullptr) {
+            return;
         }
-        else {
-            NODE *temp = root;
 
-            // loops to find proper spot for node
-            while (true) {
+        // storage from a different allocator cannot be adopted
+        if constexpr (!allocator_traits<Allocator>::is_always_equal::value) {
+            if (!(get_allocator() == other.get_allocator())) {
+                while (other.root != nullptr) {
+                    NODE *node = other.unlinkFirst();
+                    emplace(node->priority, std::move(node->value));
+                    other.freeNode(node);
+                }
+                return;
+            }
+        }
 
-                // checks if new node's priority is less
-                if (priority < temp->priority) {
+        // the union needs a valid red-black tree on both sides in balanced
+        // mode, and in the default mode no chain of sorted enqueues
+        if ((balanced && !other.balanced) || other.tooDeep()) {
+            other.rebuildBalanced();
+        }
+        unionIn(other.root, other.heightBound());
+        sz += other.sz;
+        curr = nullptr;
 
-                    // if there is no left child, the new node becomes the left child 
-                    if (temp->left == nullptr) {
-                        temp->left = newNode;
-                        newNode->parent = temp;
-                        break;
-                    }
+        pool.adopt(other.pool);
+        other.root = nullptr;
+        other.first = nullptr;
+        other.curr = nullptr;
+        other.sz = 0;
+    }
 
-                    // moves to left child
-                    temp = temp->left;
-                }
+    // reserve:
+    // Preallocates node storage so that the queue can grow to n elements
+    // without allocating. Every element, duplicates included, is one NODE.
+    // O(k), where k is the # of never-used slots in the newest slab
+    void reserve(int n) {
+        if (n > sz) {
+            pool.reserve(n - sz);
+        }
+    }
 
-                // checks if new node's priority is more
-                else if (priority > temp->priority) {
+    // shrink_to_fit:
+    // Returns node storage that no element is using back to the allocator,
+    // as far as whole slabs allow.
+    // O(f logs + s logs), where f is the # of free nodes and s the # of slabs
+    void shrink_to_fit() {
+        pool.shrink_to_fit();
+    }
 
-                    // if there is no right child, the new node becomes the right child
-                    if (temp->right == nullptr) {
-                        temp->right = newNode;
-                        newNode->parent = temp;
-                        break;
-                    }
+    // memory_usage:
+    // Returns the bytes of node storage the queue holds, used or not,
+    // including the nodes of duplicate chains. Memory owned by the values
+    // themselves (e.g. string buffers) is not counted.
+    // O(s), where s is the number of slabs
+    size_t memory_usage() const {
+        return pool.memory_usage();
+    }
 
-                    // moves to right child
-                    temp = temp->right;
-                }
+    // enqueue:
+    // Inserts the value into the custom BST in the correct location based on
+    // priority. The value is copied into its node once. Returns a handle
+    // that can be passed to update_priority and erase.
+    // O(logn), where n is number of unique nodes in tree
+    handle enqueue(const T& value, int priority) {
+        return emplace(priority, value);
+    }
 
-                // if priorities are equal
-                else {
+    // enqueue:
+    // Same as above, but moves the value into its node, so move-only types
+    // such as unique_ptr can be queued.
+    // O(logn), where n is number of unique nodes in tree
+    handle enqueue(T&& value, int priority) {
+        return emplace(priority, std::move(value));
+    }
 
-                    // if there is no linked node, it links the new node and 
-                    // sets parent of node and marks node as a duplicate
-                    if (temp->link == nullptr) {
-                        temp->link = newNode;
-                        newNode->parent = temp;
-                        temp->dup = true;
-                        break;
-                    }
+    // emplace:
+    // Constructs the value in place inside a new node from args, then
+    // inserts it like enqueue. No T is copied or moved.
+    // O(logn), where n is number of unique nodes in tree
+    template<typename... Args>
+    handle emplace(int priority, Args&&... args) {
 
-                    // creates temporary node and traverses through linked list to find last node
-                    NODE *tempLink = temp->link;
-                    while (tempLink->link != nullptr) {
-                        tempLink = tempLink->link;
-                    }
+        // creates new node with the value built from args
+        NODE *newNode = this->newNode(priority, std::forward<Args>(args)...);
+        insertNode(newNode);
+        return newNode;
+    }
 
-                    // links new node at the end of the list and sets the parent of the node
-                    tempLink->link = newNode;
-                    newNode->parent = tempLink;
-                    newNode->dup = true;
-                    break;
-                }
-            }
+    // update_priority:
+    // Moves the element behind h to the given priority, behind any elements
+    // already there. h stays valid. Nothing happens if the priority is
+    // unchanged, so the element keeps its place.
+    // O(logn), where n is number of unique nodes in tree
+    void update_priority(handle h, int priority) {
+        if (h->priority == priority) {
+            return;
         }
 
-        // increments the size of the priority queue
-        sz++;
+        detach(h);
+        h->priority = priority;
+        h->dup = false;
+        h->parent = nullptr;
+        h->link = nullptr;
+        h->tail = h;
+        h->left = nullptr;
+        h->right = nullptr;
+        h->red = true;
+        insertNode(h);
+    }
+
+    // erase:
+    // Removes the element behind h, which must still be in this queue, and
+    // destroys its value. Other handles stay valid.
+    // O(logn), where n is number of unique nodes in tree
+    void erase(handle h) {
+        detach(h);
+        freeNode(h);
     }
 
     // dequeue:
     // returns the value of the next element in the priority queue and removes
-    // the element from the priority queue.
-    // O(logn + m), where n is number of unique nodes in tree and m is number 
-    // of duplicate priorities
+    // the element from the priority queue. The node is unlinked by pointer
+    // relinking, so no other value in the tree is copied or moved and
+    // pointers to the remaining nodes stay valid.
+    // O(1) when the minimum has no right subtree, otherwise O(logn), where n
+    // is number of unique nodes in tree
     T dequeue() {
 
         // handles case where queue is empty
@@ -256,72 +1162,37 @@ public:
             return T();
         }
 
-        // finds the node with the highest priority(smallest number)
-        NODE *toDelete = root;
-        while (toDelete->left != nullptr) {
-            toDelete = toDelete->left;
-        }
-
-        // saves value to be dequeued and returned
-        T valueOut = toDelete->value;
-
-        // checks if node has linked node with same priority
-        if (toDelete->link != nullptr) {
-            NODE *temp = toDelete->link;
-            toDelete->value = temp->value;
-            toDelete->priority = temp->priority;
-            toDelete->link = temp->link;
-            delete temp;
-        }
-        else {
-            // if node to delete has right child, find the successor
-            if (toDelete->right != nullptr) {
-                NODE *suc = toDelete->right;
-                while (suc->left != nullptr) {
-                    suc = suc->left;
-                }
-
-                toDelete->value = suc->value;
-                toDelete->priority = suc->priority;
-                toDelete->link = suc->link;
-
-                // adjusts the pointers to remove the successor from the tree
-                if (suc->parent->left == suc) {
-                    suc->parent->left = suc->right;
-                }
-                else {
-                    suc->parent->right = suc->right;
-                }
-                if (suc->right != nullptr) {
-                    suc->right->parent = suc->parent;
-                }
-
-                delete suc;
+        // moves out the value to be dequeued and returned
+        NODE *toDelete = unlinkFirst();
+        T valueOut = std::move(toDelete->value);
+        freeNode(toDelete);
+        return valueOut; 
+    }
 
-                
-            }
-        
-            else {
-                // if node to delete does not have right child, remove it
-                if (toDelete->parent != nullptr) {
-                    if (toDelete->parent->left == toDelete) {
-                        toDelete->parent->left = nullptr;
-                    }
-                    else {
-                        toDelete->parent->right = nullptr;
-                    }
-                }
-                else {
-                    // if node to delete is the root, update root pointer
-                    root = nullptr;
-                }
-                delete toDelete;
-            }
+    // dequeue_n:
+    // Removes up to n elements in priority order and writes each one to out
+    // as a pair<T, int> of its value (moved out) and priority. Returns the
+    // output iterator past the last element written.
+    // O(logn + k) amortized, where k is the # of elements removed; the
+    // cached minimum means no removal descends from the root
+    template<typename OutputIt>
+    OutputIt dequeue_n(int n, OutputIt out) {
+        while (n > 0 && root != nullptr) {
+            NODE *node = unlinkFirst();
+            *out = pair<T, int>(std::move(node->value), node->priority);
+            ++out;
+            freeNode(node);
+            n--;
         }
+        return out;
+    }
 
-        // decreases size of priority queue and return dequeued node
-        sz--;
-        return valueOut; 
+    // drain:
+    // Removes every element, see dequeue_n.
+    // O(n)
+    template<typename OutputIt>
+    OutputIt drain(OutputIt out) {
+        return dequeue_n(sz, out);
     }
     
     // Size:
@@ -336,19 +1207,11 @@ public:
     // call to begin(), the internal state denotes the first inorder
     // node; this ensure that first call to next() function returns
     // the first inorder node value.
-    // O(logn), where n is number of unique nodes in tree
+    // O(1)
     void begin() {
         
-        // starts from root of BST and checks if root is nullptr
-        curr = root;
-        if (curr == nullptr) {
-            return;
-        }
-
-        // traverses to the leftmost node (smallest priority)
-        while (curr->left != nullptr) {
-            curr = curr->left;
-        }
+        // starts from the cached leftmost node (smallest priority)
+        curr = first;
     }
     
     // next
@@ -373,43 +1236,11 @@ public:
             return false;
         }
 
-        // handles duplicate priorities
-        if (curr->link != nullptr) {
-            value = curr->value;
-            priority = curr->priority;
-            curr = curr->link;
-            return true;
-        }
-
-        // stores current value and priority
+        // stores current value and priority, then moves on in priority
+        // order, along the duplicate list first
         value = curr->value;
         priority = curr->priority;
-
-        while (curr->parent != nullptr 
-            && curr->parent->priority == curr->priority) 
-        {
-            curr = curr->parent;    
-        }
-
-        // if there is a right child, this goes to right child then goes all the way left
-        if (curr->right != nullptr) {
-            // cout << "Moving Right: " << endl;
-            curr = curr->right;
-            while (curr->left != nullptr) {
-                curr = curr->left;
-            }
-        }
-        // if there is no right child, this goes back to find the next node
-        else {
-            
-            NODE *parent = curr->parent;
-            while (parent != nullptr && curr == parent->right) {
-                curr = parent;
-                parent = curr->parent;
-            }
-            curr = parent;
-
-        }
+        curr = chaintree<NODE>::advance(curr);
 
         // check if no next element was found
         if (curr == nullptr) {
@@ -460,24 +1291,16 @@ public:
     // peek:
     // returns the value of the next element in the priority queue but does not
     // remove the item from the priority queue.
-    // O(logn + m), where n is number of unique nodes in tree and m is number 
-    // of duplicate priorities
+    // O(1)
     T peek() {
 
         // handles case where queue is empty and returns default constructor
-        if (root == nullptr) {
+        if (first == nullptr) {
             return T();
         }
 
-        // finds node with highest priority (smallest number)
-        NODE *highestPriority = root;
-        while (highestPriority->left != nullptr) {
-            highestPriority = highestPriority->left;
-        }
-
         // returns value of highest priority but does not remove it
-        return highestPriority->value; 
-        
+        return first->value; 
     }
     
 
@@ -508,6 +1331,24 @@ public:
         return compareNodes(a->left, b->left) && compareNodes(a->right, b->right);
     }
 
+    // helper function for isRedBlack, returns the black height of the
+    // subtree at node or -1 if it breaks a red-black rule
+    int blackHeightCheck(NODE* node) const {
+        if (node == nullptr) {
+            return 0;
+        }
+        if (node->red && !(isBlack(node->left) && isBlack(node->right))) {
+            return -1;
+        }
+
+        int left = blackHeightCheck(node->left);
+        int right = blackHeightCheck(node->right);
+        if (left < 0 || left != right) {
+            return -1;
+        }
+        return left + (node->red ? 0 : 1);
+    }
+
     // ==operator
     // Returns true if this priority queue as the priority queue passed in as
     // other.  Otherwise returns false.
@@ -516,6 +1357,39 @@ public:
         return compareNodes(this->root, other.root);
     }
     
+    // height:
+    // Returns the # of levels of the BST, 0 if empty. Duplicate lists do
+    // not count. Used for testing the balanced mode.
+    // O(n), where n is number of unique nodes in tree
+    int height() const {
+        int levels = 0;
+        vector<pair<NODE*, int>> stack;
+        if (root != nullptr) {
+            stack.push_back({root, 1});
+        }
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            levels = max(levels, depth);
+            if (node->left != nullptr) {
+                stack.push_back({node->left, depth + 1});
+            }
+            if (node->right != nullptr) {
+                stack.push_back({node->right, depth + 1});
+            }
+        }
+        return levels;
+    }
+
+    // isRedBlack:
+    // Returns true if the BST is a valid red-black tree: the root is black,
+    // no red node has a red child and every path down to a null leaf has
+    // the same # of black nodes. Used for testing the balanced mode.
+    // O(n), where n is number of unique nodes in tree
+    bool isRedBlack() const {
+        return isBlack(root) && blackHeightCheck(root) >= 0;
+    }
+
     // getRoot - Do not edit/change!
     // Used for testing the BST.
     // return the root node for testing.
@@ -523,3 +1397,7 @@ public:
         return root;
     }
 };
+
+// prqueue whose nodes come from a std::pmr::memory_resource
+template<typename T>
+using pmr_prqueue = prqueue<T, pmr::polymorphic_allocator<T>>;
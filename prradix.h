@@ -0,0 +1,243 @@
+/// @file prradix.h
+///
+/// Radix heap engine for monotone integer priorities, with the same
+/// interface as prqueue. Only valid when every enqueued priority is >= the
+/// priority of the last dequeued element, as in Dijkstra-style searches
+/// or event simulation. Elements are kept in 33 bucket arrays keyed by the
+/// highest bit in which their priority differs from the last dequeued one,
+/// so operations are amortized O(log C) for a priority range C.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <bit>
+#include <cassert>
+
+using namespace std;
+
+template<typename T>
+class prradix {
+private:
+    struct ENTRY {
+        int priority;  // used to pick the bucket
+        T value;       // stored data for the p-queue
+    };
+    static const int NUM_BUCKETS = 33;
+
+    vector<ENTRY> buckets[NUM_BUCKETS]; // bucket 0 holds priority == last, in FIFO order
+    size_t head;        // index of the front of bucket 0
+    unsigned last;      // key of the last dequeued priority
+    int sz;             // # of elements in the prqueue
+    vector<ENTRY> order; // sorted snapshot used by begin and next
+    size_t curr;        // position of next item in order
+
+    // maps a priority onto an unsigned key with the same ordering
+    static unsigned keyOf(int priority) {
+        return (unsigned)priority ^ 0x80000000u;
+    }
+
+    // returns the bucket for key: 0 when it equals last, otherwise one more
+    // than the highest bit in which it differs from last
+    int bucketOf(unsigned key) const {
+        if (key == last) {
+            return 0;
+        }
+        return 32 - countl_zero(key ^ last);
+    }
+
+    // refill:
+    // Makes bucket 0 non-empty by advancing last to the smallest key in the
+    // lowest non-empty bucket and redistributing that bucket. Each element
+    // only ever moves to a lower bucket, which bounds the total work.
+    // Amortized O(log C)
+    void refill() {
+        if (head < buckets[0].size()) {
+            return;
+        }
+        buckets[0].clear();
+        head = 0;
+
+        int i = 1;
+        while (buckets[i].empty()) {
+            i++;
+        }
+
+        // finds the new minimum of the bucket
+        unsigned minKey = keyOf(buckets[i][0].priority);
+        for (const ENTRY &e : buckets[i]) {
+            minKey = min(minKey, keyOf(e.priority));
+        }
+        last = minKey;
+
+        // moves every element down, keeping the order of equal priorities
+        vector<ENTRY> moving;
+        moving.swap(buckets[i]);
+        for (ENTRY &e : moving) {
+            buckets[bucketOf(keyOf(e.priority))].push_back(std::move(e));
+        }
+    }
+
+    // fills out with every element, sorted by priority and FIFO among
+    // equal priorities
+    // O(nlogn)
+    void snapshot(vector<ENTRY>& out) const {
+        out.clear();
+        out.reserve(sz);
+        for (size_t j = head; j < buckets[0].size(); j++) {
+            out.push_back(buckets[0][j]);
+        }
+        for (int i = 1; i < NUM_BUCKETS; i++) {
+            out.insert(out.end(), buckets[i].begin(), buckets[i].end());
+        }
+
+        // equal priorities always share a bucket, so a stable sort keeps FIFO
+        stable_sort(out.begin(), out.end(), [](const ENTRY& a, const ENTRY& b) {
+            return a.priority < b.priority;
+        });
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue. Any priority may be enqueued until
+    // the first dequeue.
+    // O(1)
+    prradix() {
+        head = 0;
+        last = 0;
+        sz = 0;
+        curr = 0;
+    }
+
+    // clear:
+    // Removes every element and resets the monotonicity bound.
+    // O(n)
+    void clear() {
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            buckets[i].clear();
+        }
+        order.clear();
+        head = 0;
+        last = 0;
+        sz = 0;
+        curr = 0;
+    }
+
+    // enqueue:
+    // Inserts the value in the bucket for its priority. The priority must be
+    // >= the priority of the last dequeued element; this is asserted.
+    // O(1)
+    void enqueue(T value, int priority) {
+        unsigned key = keyOf(priority);
+        assert(key >= last && "prradix priorities must not go below the last dequeued one");
+
+        buckets[bucketOf(key)].push_back(ENTRY{priority, std::move(value)});
+        sz++;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // Amortized O(log C)
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (sz == 0) {
+            return T();
+        }
+
+        refill();
+        T valueOut = std::move(buckets[0][head].value);
+        head++;
+        sz--;
+
+        // drops the consumed front of bucket 0, which never runs dry while
+        // priorities keep arriving at last, amortized O(1)
+        if (head >= 32 && head * 2 >= buckets[0].size()) {
+            buckets[0].erase(buckets[0].begin(), buckets[0].begin() + head);
+            head = 0;
+        }
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an in-priority-order traversal from a sorted
+    // snapshot; enqueue or dequeue invalidates it.
+    // O(nlogn)
+    void begin() {
+        snapshot(order);
+        curr = 0;
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1)
+    bool next(T& value, int &priority) {
+        if (curr >= order.size()) {
+            return false;
+        }
+
+        value = order[curr].value;
+        priority = order[curr].priority;
+        curr++;
+
+        return curr < order.size();
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(nlogn)
+    string toString() {
+        vector<ENTRY> all;
+        snapshot(all);
+
+        stringstream ss;
+        for (const ENTRY &e : all) {
+            ss << e.priority << " value: " << e.value << endl;
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue. Unlike dequeue this does not
+    // advance the monotonicity bound.
+    // O(1) when the minimum is already in bucket 0, otherwise O(b) where b is
+    // the size of the lowest non-empty bucket
+    T peek() {
+        if (sz == 0) {
+            return T();
+        }
+        if (head < buckets[0].size()) {
+            return buckets[0][head].value;
+        }
+
+        int i = 1;
+        while (buckets[i].empty()) {
+            i++;
+        }
+
+        // the first occurrence of the minimum was enqueued first
+        const ENTRY *best = &buckets[i][0];
+        for (const ENTRY &e : buckets[i]) {
+            if (e.priority < best->priority) {
+                best = &e;
+            }
+        }
+        return best->value;
+    }
+};
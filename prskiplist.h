@@ -0,0 +1,284 @@
+/// @file prskiplist.h
+///
+/// Skip list engine with the same interface as prqueue, including begin
+/// and next. Insertion is expected O(logn) without any rebalancing, the
+/// minimum is always the first node on level 0 so it is removed in O(1)
+/// expected time, and in-order traversal just follows level 0. Equal
+/// priorities are inserted after each other, so they stay FIFO.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <bit>
+#include <cstdint>
+
+using namespace std;
+
+template<typename T>
+class prskiplist {
+private:
+    static const int MAX_LEVEL = 32;
+
+    struct NODE {
+        int priority;    // used to order the list
+        T value;         // stored data for the p-queue
+        int level;       // # of forward links
+        NODE** forward;  // forward[i] links to next node on level i
+    };
+    NODE* head[MAX_LEVEL]; // first node on each level
+    int level;             // # of levels in use
+    int sz;                // # of elements in the prqueue
+    NODE* curr;            // pointer to next item in prqueue (see begin and next)
+    uint64_t seed;         // state of the level generator
+
+    // returns a random level, each extra level with probability 1/2
+    // O(1)
+    int randomLevel() {
+        // xorshift64
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        // trailing zero bits are fair coin flips
+        return 1 + countr_zero(seed | (1ULL << (MAX_LEVEL - 1)));
+    }
+
+    // allocates a node with lvl forward links, all null
+    static NODE* newNode(T value, int priority, int lvl) {
+        NODE *node = new NODE{priority, std::move(value), lvl, new NODE*[lvl]};
+        for (int i = 0; i < lvl; i++) {
+            node->forward[i] = nullptr;
+        }
+        return node;
+    }
+
+    // frees a node and its forward links
+    static void deleteNode(NODE* node) {
+        delete[] node->forward;
+        delete node;
+    }
+
+    // returns the link that points at the successor of prev on level i,
+    // where a null prev stands for the head
+    NODE*& link(NODE* prev, int i) {
+        return (prev == nullptr) ? head[i] : prev->forward[i];
+    }
+
+    // copies the nodes of other in order, appending each at the end of
+    // every level it reaches
+    // O(n)
+    void copyFrom(const prskiplist& other) {
+        NODE *last[MAX_LEVEL];
+        for (int i = 0; i < MAX_LEVEL; i++) {
+            last[i] = nullptr;
+        }
+
+        for (NODE *node = other.head[0]; node != nullptr; node = node->forward[0]) {
+            NODE *copied = newNode(node->value, node->priority, node->level);
+            for (int i = 0; i < copied->level; i++) {
+                link(last[i], i) = copied;
+                last[i] = copied;
+            }
+        }
+        level = other.level;
+        sz = other.sz;
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue.
+    // O(1)
+    prskiplist() {
+        for (int i = 0; i < MAX_LEVEL; i++) {
+            head[i] = nullptr;
+        }
+        level = 0;
+        sz = 0;
+        curr = nullptr;
+        seed = 0x9E3779B97F4A7C15ULL;
+    }
+
+    // copy constructor:
+    // Makes a deep copy of other with the same tower heights.
+    // O(n)
+    prskiplist(const prskiplist& other) : prskiplist() {
+        copyFrom(other);
+    }
+
+    // operator=
+    // Clears "this" list and then makes a copy of the "other" list.
+    // O(n)
+    prskiplist& operator=(const prskiplist& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        copyFrom(other);
+        return *this;
+    }
+
+    // clear:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    void clear() {
+        NODE *node = head[0];
+        while (node != nullptr) {
+            NODE *toDelete = node;
+            node = node->forward[0];
+            deleteNode(toDelete);
+        }
+
+        for (int i = 0; i < MAX_LEVEL; i++) {
+            head[i] = nullptr;
+        }
+        level = 0;
+        sz = 0;
+        curr = nullptr;
+    }
+
+    // destructor:
+    // Frees the memory associated with the priority queue.
+    // O(n)
+    ~prskiplist() {
+        clear();
+    }
+
+    // enqueue:
+    // Inserts the value after every element with a priority <= priority.
+    // Expected O(logn)
+    void enqueue(T value, int priority) {
+        NODE *update[MAX_LEVEL];
+
+        // finds the last node before the insertion point on every level
+        NODE *prev = nullptr;
+        for (int i = level - 1; i >= 0; i--) {
+            NODE *nextNode = link(prev, i);
+            while (nextNode != nullptr && nextNode->priority <= priority) {
+                prev = nextNode;
+                nextNode = prev->forward[i];
+            }
+            update[i] = prev;
+        }
+
+        // new levels start at the head
+        int lvl = randomLevel();
+        for (int i = level; i < lvl; i++) {
+            update[i] = nullptr;
+        }
+        if (lvl > level) {
+            level = lvl;
+        }
+
+        // splices the node in on each of its levels
+        NODE *node = newNode(std::move(value), priority, lvl);
+        for (int i = 0; i < lvl; i++) {
+            NODE *&in = link(update[i], i);
+            node->forward[i] = in;
+            in = node;
+        }
+
+        sz++;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // Expected O(1)
+    T dequeue() {
+
+        // handles case where queue is empty
+        if (head[0] == nullptr) {
+            return T();
+        }
+
+        // the first node is the head's successor on each of its levels
+        NODE *toDelete = head[0];
+        for (int i = 0; i < toDelete->level; i++) {
+            head[i] = toDelete->forward[i];
+        }
+        while (level > 0 && head[level - 1] == nullptr) {
+            level--;
+        }
+
+        T valueOut = std::move(toDelete->value);
+        deleteNode(toDelete);
+        sz--;
+
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return sz;
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1)
+    void begin() {
+        curr = head[0];
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1)
+    bool next(T& value, int &priority) {
+        if (curr == nullptr) {
+            return false;
+        }
+
+        value = curr->value;
+        priority = curr->priority;
+        curr = curr->forward[0];
+
+        return curr != nullptr;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n)
+    string toString() {
+        stringstream ss;
+        for (NODE *node = head[0]; node != nullptr; node = node->forward[0]) {
+            ss << node->priority << " value: " << node->value << endl;
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (head[0] == nullptr) {
+            return T();
+        }
+        return head[0]->value;
+    }
+
+    // ==operator
+    // Returns true if both lists hold the same values and priorities in the
+    // same order.
+    // O(n)
+    bool operator==(const prskiplist& other) const {
+        NODE *a = head[0];
+        NODE *b = other.head[0];
+        while (a != nullptr && b != nullptr) {
+            if (a->priority != b->priority || a->value != b->value) {
+                return false;
+            }
+            a = a->forward[0];
+            b = b->forward[0];
+        }
+        return a == nullptr && b == nullptr;
+    }
+};
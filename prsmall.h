@@ -0,0 +1,256 @@
+/// @file prsmall.h
+///
+/// Small-buffer variant of prqueue for queues that are usually short. The
+/// first N elements live inside the object in a sorted array, so a queue
+/// that never holds more than N elements never allocates and peek is a
+/// single load. Growing past N spills every element into a prqueue, which
+/// is used until the queue is empty again. Equal priorities stay FIFO in
+/// both modes.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <type_traits>
+#include "prqueue.h"
+
+using namespace std;
+
+template<typename T, int N = 8>
+class prsmall {
+private:
+    static_assert(N > 0, "prsmall<T, N> needs room for at least one element");
+
+    // inline elements, sorted by descending priority with later arrivals
+    // first among equal ones, so the next to dequeue is at count - 1
+    int priorities[N];
+    T values[N];
+    int count;         // # of inline elements
+    bool spilled;      // true while the elements live in tree instead
+    prqueue<T> tree;   // holds the elements once more than N were queued
+    int curr;          // index of next inline item (see begin and next)
+
+    // moves the inline elements into the tree, in dequeue order
+    // O(N logN)
+    void spill() {
+        for (int i = count - 1; i >= 0; i--) {
+            tree.enqueue(std::move(values[i]), priorities[i]);
+            values[i] = T();
+        }
+        count = 0;
+        spilled = true;
+    }
+
+public:
+
+    // default constructor:
+    // Creates an empty priority queue. balanced is passed on to the tree
+    // used after spilling.
+    // O(N), to default construct the inline values
+    explicit prsmall(bool balanced = false) : tree(balanced) {
+        count = 0;
+        spilled = false;
+        curr = -1;
+    }
+
+    // copies are deep, like prqueue's
+    prsmall(const prsmall&) = default;
+    prsmall& operator=(const prsmall&) = default;
+
+    // move constructor:
+    // Moves the inline elements over and takes over the tree of other,
+    // which is left empty.
+    // O(N)
+    prsmall(prsmall&& other) noexcept(is_nothrow_move_assignable_v<T>)
+        : tree(std::move(other.tree)) {
+        count = other.count;
+        spilled = other.spilled;
+        curr = -1;
+        for (int i = 0; i < count; i++) {
+            priorities[i] = other.priorities[i];
+            values[i] = std::move(other.values[i]);
+        }
+        other.count = 0;
+        other.spilled = false;
+        other.curr = -1;
+    }
+
+    // move assignment:
+    // Same as the move constructor, after dropping this queue's elements.
+    // O(N), plus O(n) to clear a spilled tree
+    prsmall& operator=(prsmall&& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        clear();
+        tree = std::move(other.tree);
+        count = other.count;
+        spilled = other.spilled;
+        for (int i = 0; i < count; i++) {
+            priorities[i] = other.priorities[i];
+            values[i] = std::move(other.values[i]);
+        }
+        other.count = 0;
+        other.spilled = false;
+        other.curr = -1;
+        return *this;
+    }
+
+    // clear:
+    // Empties the queue and goes back to inline storage.
+    // O(n)
+    void clear() {
+        for (int i = 0; i < count; i++) {
+            values[i] = T();
+        }
+        count = 0;
+        tree.clear();
+        spilled = false;
+        curr = -1;
+    }
+
+    // enqueue:
+    // Inserts the value after every element with a priority <= priority,
+    // inline while there is room and in the tree after that.
+    // O(N) inline, O(logn) once spilled
+    void enqueue(const T& value, int priority) {
+        enqueue(T(value), priority);
+    }
+
+    // enqueue:
+    // Same as above, but moves the value in.
+    // O(N) inline, O(logn) once spilled
+    void enqueue(T&& value, int priority) {
+        if (!spilled && count == N) {
+            spill();
+        }
+        if (spilled) {
+            tree.enqueue(std::move(value), priority);
+            return;
+        }
+
+        // finds the first slot that leaves after the new element
+        int pos = 0;
+        while (pos < count && priorities[pos] > priority) {
+            pos++;
+        }
+
+        // shifts the rest up to make room
+        for (int i = count; i > pos; i--) {
+            priorities[i] = priorities[i - 1];
+            values[i] = std::move(values[i - 1]);
+        }
+        priorities[pos] = priority;
+        values[pos] = std::move(value);
+        count++;
+    }
+
+    // dequeue:
+    // returns the value of the next element in the priority queue and removes
+    // the element from the priority queue.
+    // O(1) inline, O(logn) once spilled
+    T dequeue() {
+        if (spilled) {
+            T valueOut = tree.dequeue();
+
+            // back to inline storage once the tree drains
+            if (tree.size() == 0) {
+                spilled = false;
+            }
+            return valueOut;
+        }
+
+        // handles case where queue is empty
+        if (count == 0) {
+            return T();
+        }
+
+        count--;
+        T valueOut = std::move(values[count]);
+        values[count] = T();
+        return valueOut;
+    }
+
+    // Size:
+    // Returns the # of elements in the priority queue, 0 if empty.
+    // O(1)
+    int size() {
+        return spilled ? tree.size() : count;
+    }
+
+    // returns true while the elements are held in the tree
+    bool isSpilled() const {
+        return spilled;
+    }
+
+    // memory_usage:
+    // Returns the bytes of heap storage held for nodes, 0 for a queue that
+    // never spilled.
+    // O(s), where s is the number of slabs
+    size_t memory_usage() const {
+        return tree.memory_usage();
+    }
+
+    // begin
+    // Resets internal state for an inorder traversal, so that the first call
+    // to next() returns the first element in priority order.
+    // O(1)
+    void begin() {
+        if (spilled) {
+            tree.begin();
+        }
+        else {
+            curr = count - 1;
+        }
+    }
+
+    // next
+    // Same contract as prqueue::next: returns the next value/priority via
+    // the reference parameters, and returns false once the last one has
+    // been handed out or none are left.
+    // O(1) inline, O(logn) once spilled
+    bool next(T& value, int &priority) {
+        if (spilled) {
+            return tree.next(value, priority);
+        }
+        if (curr < 0) {
+            return false;
+        }
+
+        value = values[curr];
+        priority = priorities[curr];
+        curr--;
+        return curr >= 0;
+    }
+
+    // toString:
+    // Returns a string of the entire priority queue, in order
+    // O(n)
+    string toString() {
+        if (spilled) {
+            return tree.toString();
+        }
+
+        stringstream ss;
+        for (int i = count - 1; i >= 0; i--) {
+            ss << priorities[i] << " value: " << values[i] << endl;
+        }
+        return ss.str();
+    }
+
+    // peek:
+    // returns the value of the next element in the priority queue but does not
+    // remove the item from the priority queue.
+    // O(1)
+    T peek() {
+        if (spilled) {
+            return tree.peek();
+        }
+        if (count == 0) {
+            return T();
+        }
+        return values[count - 1];
+    }
+};
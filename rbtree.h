@@ -0,0 +1,353 @@
+/// @file rbtree.h
+///
+/// Red-black tree code shared by the BST engines (prqueue, printrusive and
+/// prcompact), so that balancing and the duplicate list handling live in
+/// one place.
+///
+/// rbtree<Links> holds the rotations, the insert/erase fixups and the
+/// in-order successor. It is written against a Links policy that says how
+/// to follow a node's links, so the same code runs on nodes linked by
+/// pointers and on nodes linked by array indices:
+///
+///     using ref = ...;          // NODE* or an index
+///     ref nil() const;          // the null link
+///     ref& root();              // root of the tree
+///     ref& left(ref node);      // links of a node, assignable
+///     ref& right(ref node);
+///     ref& parent(ref node);
+///     bool& red(ref node);      // color of a node, assignable
+///
+/// pointerLinks<NODE> is the Links for NODEs with left/right/parent/red
+/// pointer fields. chaintree<NODE> adds the operations on the duplicate
+/// lists that prqueue NODEs and prhooks hang off their BST nodes.
+
+#pragma once
+
+using namespace std;
+
+template<typename Links>
+class rbtree {
+private:
+    using ref = typename Links::ref;
+    Links t;  // how to reach the links of a node
+
+public:
+
+    // constructor:
+    // Works on the tree that links reaches.
+    // O(1)
+    explicit rbtree(Links links) : t(links) {}
+
+    // returns true if node is black, null leaves count as black
+    bool isBlack(ref node) {
+        return node == t.nil() || !t.red(node);
+    }
+
+    // replaces the child link of parent that points at oldChild, or the root
+    // when parent is null
+    // O(1)
+    void replaceChild(ref parent, ref oldChild, ref newChild) {
+        if (parent == t.nil()) {
+            t.root() = newChild;
+        }
+        else if (t.left(parent) == oldChild) {
+            t.left(parent) = newChild;
+        }
+        else {
+            t.right(parent) = newChild;
+        }
+    }
+
+    // rotateLeft:
+    // Rotates the subtree rooted at node to the left, so that the right
+    // child of node takes its place. Duplicate lists are untouched.
+    // O(1)
+    void rotateLeft(ref node) {
+        ref child = t.right(node);
+
+        // moves the left subtree of child over to node
+        t.right(node) = t.left(child);
+        if (t.left(child) != t.nil()) {
+            t.parent(t.left(child)) = node;
+        }
+
+        // hooks child into the spot node used to occupy
+        t.parent(child) = t.parent(node);
+        replaceChild(t.parent(node), node, child);
+        t.left(child) = node;
+        t.parent(node) = child;
+    }
+
+    // rotateRight:
+    // Mirror image of rotateLeft.
+    // O(1)
+    void rotateRight(ref node) {
+        ref child = t.left(node);
+
+        // moves the right subtree of child over to node
+        t.left(node) = t.right(child);
+        if (t.right(child) != t.nil()) {
+            t.parent(t.right(child)) = node;
+        }
+
+        // hooks child into the spot node used to occupy
+        t.parent(child) = t.parent(node);
+        replaceChild(t.parent(node), node, child);
+        t.right(child) = node;
+        t.parent(node) = child;
+    }
+
+    // insertFixup:
+    // Restores the red-black properties after node was attached as a new
+    // red leaf of the BST.
+    // O(logn), where n is number of unique nodes in tree
+    void insertFixup(ref node) {
+        while (t.parent(node) != t.nil() && t.red(t.parent(node))) {
+            ref parent = t.parent(node);
+            ref grand = t.parent(parent);
+            bool parentIsLeft = (parent == t.left(grand));
+            ref uncle = parentIsLeft ? t.right(grand) : t.left(grand);
+
+            // red uncle, recolor and continue from the grandparent
+            if (!isBlack(uncle)) {
+                t.red(parent) = false;
+                t.red(uncle) = false;
+                t.red(grand) = true;
+                node = grand;
+                continue;
+            }
+
+            // node is an inner child, rotate it to the outside first
+            if (parentIsLeft && node == t.right(parent)) {
+                rotateLeft(parent);
+                node = parent;
+                parent = t.parent(node);
+            }
+            else if (!parentIsLeft && node == t.left(parent)) {
+                rotateRight(parent);
+                node = parent;
+                parent = t.parent(node);
+            }
+
+            t.red(parent) = false;
+            t.red(grand) = true;
+            if (parentIsLeft) {
+                rotateRight(grand);
+            }
+            else {
+                rotateLeft(grand);
+            }
+        }
+
+        t.red(t.root()) = false;
+    }
+
+    // eraseFixup:
+    // Restores the red-black properties after a black node was unlinked
+    // from the BST. node is the child that took its place (may be null)
+    // and parent is the parent of that spot.
+    // O(logn), where n is number of unique nodes in tree
+    void eraseFixup(ref node, ref parent) {
+        while (node != t.root() && isBlack(node)) {
+            bool isLeft = (node == t.left(parent));
+            ref sibling = isLeft ? t.right(parent) : t.left(parent);
+
+            // red sibling, rotate so that the sibling becomes black
+            if (!isBlack(sibling)) {
+                t.red(sibling) = false;
+                t.red(parent) = true;
+                if (isLeft) {
+                    rotateLeft(parent);
+                    sibling = t.right(parent);
+                }
+                else {
+                    rotateRight(parent);
+                    sibling = t.left(parent);
+                }
+            }
+
+            ref nearChild = isLeft ? t.left(sibling) : t.right(sibling);
+            ref farChild = isLeft ? t.right(sibling) : t.left(sibling);
+
+            // both nephews black, push the missing black up a level
+            if (isBlack(nearChild) && isBlack(farChild)) {
+                t.red(sibling) = true;
+                node = parent;
+                parent = t.parent(node);
+                continue;
+            }
+
+            // far nephew black, rotate the near nephew into its place
+            if (isBlack(farChild)) {
+                t.red(nearChild) = false;
+                t.red(sibling) = true;
+                if (isLeft) {
+                    rotateRight(sibling);
+                    sibling = t.right(parent);
+                }
+                else {
+                    rotateLeft(sibling);
+                    sibling = t.left(parent);
+                }
+                farChild = isLeft ? t.right(sibling) : t.left(sibling);
+            }
+
+            t.red(sibling) = t.red(parent);
+            t.red(parent) = false;
+            t.red(farChild) = false;
+            if (isLeft) {
+                rotateLeft(parent);
+            }
+            else {
+                rotateRight(parent);
+            }
+            node = t.root();
+        }
+
+        if (node != t.nil()) {
+            t.red(node) = false;
+        }
+    }
+
+    // returns the leftmost node below node, node itself if it has no left
+    // child
+    // O(logn), where n is number of unique nodes in tree
+    ref leftmost(ref node) {
+        while (t.left(node) != t.nil()) {
+            node = t.left(node);
+        }
+        return node;
+    }
+
+    // returns the in-order successor of a BST node, or null for the last
+    // O(logn), where n is number of unique nodes in tree
+    ref successor(ref node) {
+        if (t.right(node) != t.nil()) {
+            return leftmost(t.right(node));
+        }
+
+        ref parent = t.parent(node);
+        while (parent != t.nil() && node == t.right(parent)) {
+            node = parent;
+            parent = t.parent(node);
+        }
+        return parent;
+    }
+};
+
+// Links for NODEs that point at each other through left, right and parent
+template<typename NODE>
+struct pointerLinks {
+    using ref = NODE*;
+    NODE** rootLink;  // where the tree keeps its root
+
+    ref nil() const {
+        return nullptr;
+    }
+    ref& root() {
+        return *rootLink;
+    }
+    ref& left(ref node) {
+        return node->left;
+    }
+    ref& right(ref node) {
+        return node->right;
+    }
+    ref& parent(ref node) {
+        return node->parent;
+    }
+    bool& red(ref node) {
+        return node->red;
+    }
+};
+
+// Operations on a pointer-linked BST whose equal priorities are kept in a
+// duplicate list behind their BST node. NODE needs the fields priority,
+// dup, parent, link, tail, left, right and red: a list member's parent is
+// the node before it and a BST node's tail is its last list member, or
+// itself.
+template<typename NODE>
+class chaintree {
+public:
+
+    // returns the balancing code for the tree rooted at root
+    static rbtree<pointerLinks<NODE>> tree(NODE*& root) {
+        return rbtree<pointerLinks<NODE>>(pointerLinks<NODE>{&root});
+    }
+
+    // unlinkFirst:
+    // Unlinks first, the leftmost BST node, by pointer relinking and moves
+    // first on to the new minimum. The first duplicate, if any, takes over
+    // the node's place in the tree. The tree must not be empty, and the
+    // unlinked node's own links are left as they were.
+    // O(1) when the minimum has no right subtree, otherwise O(logn), where n
+    // is number of unique nodes in tree; a run of k calls walks the tree
+    // in order once, O(logn + k) amortized
+    static NODE* unlinkFirst(NODE*& root, NODE*& first, bool balanced) {
+
+        // as the leftmost node it has no left child
+        NODE *toDelete = first;
+
+        if (toDelete->link != nullptr) {
+
+            // the first duplicate takes over the node's place in the tree
+            NODE *heir = toDelete->link;
+            heir->parent = toDelete->parent;
+            heir->right = toDelete->right;
+            heir->left = nullptr;
+            heir->red = toDelete->red;
+            heir->tail = (toDelete->tail == heir) ? heir : toDelete->tail;
+            heir->dup = (heir->link != nullptr);
+            if (heir->right != nullptr) {
+                heir->right->parent = heir;
+            }
+            tree(root).replaceChild(toDelete->parent, toDelete, heir);
+            first = heir;
+        }
+        else {
+            // the right subtree, if any, moves up into the node's place
+            NODE *child = toDelete->right;
+            NODE *parent = toDelete->parent;
+            tree(root).replaceChild(parent, toDelete, child);
+
+            // the new minimum is the leftmost node of that subtree,
+            // or the parent when there is none
+            if (child != nullptr) {
+                child->parent = parent;
+                first = tree(root).leftmost(child);
+            }
+            else {
+                first = parent;
+            }
+
+            // rebalances if a black node left the tree
+            if (balanced && !toDelete->red) {
+                tree(root).eraseFixup(child, parent);
+            }
+        }
+
+        return toDelete;
+    }
+
+    // advance:
+    // Returns the node after item in priority order, FIFO among equal
+    // priorities, or null if item is the last one.
+    // O(logn), where n is the number of unique nodes in tree
+    static NODE* advance(NODE* item) {
+
+        // handles duplicate priorities
+        if (item->link != nullptr) {
+            return item->link;
+        }
+
+        // climbs back from the end of a duplicate list to its BST node
+        while (item->parent != nullptr && item->parent->priority == item->priority) {
+            item = item->parent;
+        }
+
+        // goes right then all the way left, or up until coming from a left
+        // child; successor never looks at the root
+        NODE *root = nullptr;
+        return tree(root).successor(item);
+    }
+};
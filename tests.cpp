@@ -14,6 +14,17 @@
 #define CATCH_CONFIG_MAIN
 
 #include "prqueue.h"
+#include "prheap.h"
+#include "prradix.h"
+#include "prbucket.h"
+#include "prpairing.h"
+#include "prskiplist.h"
+#include "prbtree.h"
+#include "prbitmap.h"
+#include "prcompact.h"
+#include "printrusive.h"
+#include "prsmall.h"
+#include <array>
 #include "catch.hpp"
 
 using namespace std;
@@ -620,3 +631,2205 @@ TEST_CASE("MULTIPLE FUNCTION CALLS TEST") {
         REQUIRE(pq1 == pq3);
     }
 }
+
+// tests the red-black balanced mode with sorted and duplicate priorities
+TEST_CASE("Test 11: Balanced Mode Test") {
+    prqueue<int> pq(true);
+
+    SECTION("Sorted priorities dequeue in order") {
+        for (int i = 0; i < 1000; i++) {
+            pq.enqueue(i * 10, i);
+        }
+        REQUIRE(pq.size() == 1000);
+
+        for (int i = 0; i < 1000; i++) {
+            REQUIRE(pq.peek() == i * 10);
+            REQUIRE(pq.dequeue() == i * 10);
+        }
+        REQUIRE(pq.size() == 0);
+        REQUIRE(pq.dequeue() == 0);
+    }
+
+    SECTION("Duplicate priorities keep FIFO order") {
+        for (int i = 10; i > 0; i--) {
+            pq.enqueue(i, i % 3);
+        }
+
+        string expected = "0 value: 9\n0 value: 6\n0 value: 3\n"
+                          "1 value: 10\n1 value: 7\n1 value: 4\n1 value: 1\n"
+                          "2 value: 8\n2 value: 5\n2 value: 2\n";
+        REQUIRE(pq.toString() == expected);
+
+        int val;
+        int priority;
+        pq.begin();
+        REQUIRE(pq.next(val, priority) == true);
+        REQUIRE(val == 9);
+        REQUIRE(priority == 0);
+
+        REQUIRE(pq.dequeue() == 9);
+        REQUIRE(pq.dequeue() == 6);
+        REQUIRE(pq.dequeue() == 3);
+        REQUIRE(pq.dequeue() == 10);
+        REQUIRE(pq.size() == 6);
+    }
+
+    SECTION("Operator= copies a balanced queue") {
+        prqueue<int> pq2;
+        for (int i = 0; i < 50; i++) {
+            pq.enqueue(i, 50 - i);
+        }
+        pq2 = pq;
+
+        REQUIRE(pq2 == pq);
+        REQUIRE(pq2.toString() == pq.toString());
+        for (int i = 49; i >= 0; i--) {
+            REQUIRE(pq2.dequeue() == i);
+        }
+        REQUIRE(pq.size() == 50);
+    }
+
+    SECTION("Sorted input stays a valid red-black tree") {
+        prqueue<int> plain;
+        for (int i = 0; i < 1000; i++) {
+            pq.enqueue(i, i);
+            plain.enqueue(i, i);
+        }
+
+        // a red-black tree of n nodes is at most 2 log2(n + 1) levels deep,
+        // while the same input in the default mode is a chain
+        REQUIRE(pq.isRedBlack());
+        REQUIRE(pq.height() <= 2 * log2(1000 + 1));
+        REQUIRE(plain.height() == 1000);
+        REQUIRE_FALSE(plain.isRedBlack());
+
+        // dequeues, erases and duplicates keep it valid
+        vector<prqueue<int>::handle> handles;
+        for (int i = 0; i < 3000; i++) {
+            handles.push_back(pq.enqueue(i, (i * 7919) % 2000));
+        }
+        for (int i = 0; i < 3000; i += 2) {
+            pq.erase(handles[i]);
+            if (i % 100 == 0) {
+                REQUIRE(pq.isRedBlack());
+            }
+        }
+        REQUIRE(pq.isRedBlack());
+        REQUIRE(pq.height() <= 2 * log2(pq.size() + 1));
+        while (pq.size() > 0) {
+            pq.dequeue();
+            if (pq.size() % 97 == 0) {
+                REQUIRE(pq.isRedBlack());
+            }
+        }
+        REQUIRE(pq.height() == 0);
+    }
+}
+
+// tests that peek, dequeue and begin follow the minimum as it moves
+TEST_CASE("Test 12: Cached Minimum Test") {
+    prqueue<int> pq;
+
+    SECTION("Enqueueing a new minimum updates peek") {
+        pq.enqueue(50, 5);
+        REQUIRE(pq.peek() == 50);
+        pq.enqueue(70, 7);
+        REQUIRE(pq.peek() == 50);
+        pq.enqueue(30, 3);
+        REQUIRE(pq.peek() == 30);
+        pq.enqueue(40, 4);
+        REQUIRE(pq.peek() == 30);
+        pq.enqueue(10, 1);
+        REQUIRE(pq.peek() == 10);
+    }
+
+    SECTION("Dequeue moves the minimum to the successor") {
+        pq.enqueue(50, 5);
+        pq.enqueue(30, 3);
+        pq.enqueue(40, 4);
+        pq.enqueue(35, 3);
+        pq.enqueue(70, 7);
+
+        REQUIRE(pq.dequeue() == 30);
+        REQUIRE(pq.peek() == 35);
+        REQUIRE(pq.dequeue() == 35);
+        REQUIRE(pq.peek() == 40);
+        REQUIRE(pq.dequeue() == 40);
+        REQUIRE(pq.peek() == 50);
+
+        pq.enqueue(20, 2);
+        REQUIRE(pq.peek() == 20);
+
+        int val;
+        int priority;
+        pq.begin();
+        REQUIRE(pq.next(val, priority) == true);
+        REQUIRE(val == 20);
+        REQUIRE(priority == 2);
+    }
+
+    SECTION("Clear and operator= reset the minimum") {
+        prqueue<int> pq2;
+        pq.enqueue(50, 5);
+        pq.enqueue(30, 3);
+        pq2 = pq;
+        REQUIRE(pq2.peek() == 30);
+
+        pq.clear();
+        REQUIRE(pq.peek() == 0);
+        pq.enqueue(90, 9);
+        REQUIRE(pq.peek() == 90);
+        REQUIRE(pq2.peek() == 30);
+    }
+}
+
+// tests large bursts of equal priorities, which append at the list tail
+TEST_CASE("Test 13: Duplicate Burst Test") {
+    prqueue<int> pq;
+
+    SECTION("Burst of equal priorities stays FIFO") {
+        for (int i = 0; i < 100000; i++) {
+            pq.enqueue(i, 7);
+        }
+        REQUIRE(pq.size() == 100000);
+
+        for (int i = 0; i < 100000; i++) {
+            REQUIRE(pq.dequeue() == i);
+        }
+        REQUIRE(pq.size() == 0);
+    }
+
+    SECTION("Appending after the list was drained and refilled") {
+        pq.enqueue(1, 2);
+        pq.enqueue(2, 2);
+        pq.enqueue(3, 5);
+        pq.enqueue(4, 5);
+
+        REQUIRE(pq.dequeue() == 1);
+        REQUIRE(pq.dequeue() == 2);
+        pq.enqueue(5, 5);
+        pq.enqueue(6, 2);
+        pq.enqueue(7, 2);
+
+        REQUIRE(pq.toString() == "2 value: 6\n2 value: 7\n5 value: 3\n5 value: 4\n5 value: 5\n");
+    }
+
+    SECTION("Copies append at the end of their own lists") {
+        prqueue<int> pq2;
+        pq.enqueue(1, 2);
+        pq.enqueue(2, 2);
+        pq2 = pq;
+        pq2.enqueue(3, 2);
+        pq.enqueue(4, 2);
+
+        REQUIRE(pq.toString() == "2 value: 1\n2 value: 2\n2 value: 4\n");
+        REQUIRE(pq2.toString() == "2 value: 1\n2 value: 2\n2 value: 3\n");
+    }
+}
+
+// tests the array-backed heap engine against the BST prqueue
+TEST_CASE("Test 14: Binary Heap Engine Test") {
+    prheap<string> ph;
+
+    SECTION("Empty heap") {
+        REQUIRE(ph.size() == 0);
+        REQUIRE(ph.peek() == "");
+        REQUIRE(ph.dequeue() == "");
+    }
+
+    SECTION("Equal priorities dequeue in FIFO order") {
+        ph.enqueue("Ben", 2);
+        ph.enqueue("Jen", 1);
+        ph.enqueue("Sven", 2);
+        ph.enqueue("Gwen", 1);
+        ph.enqueue("Raven", 2);
+
+        REQUIRE(ph.size() == 5);
+        REQUIRE(ph.toString() == "1 value: Jen\n1 value: Gwen\n2 value: Ben\n2 value: Sven\n2 value: Raven\n");
+        REQUIRE(ph.peek() == "Jen");
+        REQUIRE(ph.dequeue() == "Jen");
+        REQUIRE(ph.dequeue() == "Gwen");
+        REQUIRE(ph.dequeue() == "Ben");
+        REQUIRE(ph.dequeue() == "Sven");
+        REQUIRE(ph.dequeue() == "Raven");
+        REQUIRE(ph.size() == 0);
+    }
+
+    SECTION("Begin and next walk in priority order") {
+        ph.enqueue("c", 3);
+        ph.enqueue("a", 1);
+        ph.enqueue("b", 2);
+
+        string val;
+        int priority;
+        ph.begin();
+        REQUIRE(ph.next(val, priority) == true);
+        REQUIRE(val == "a");
+        REQUIRE(ph.next(val, priority) == true);
+        REQUIRE(val == "b");
+        REQUIRE(ph.next(val, priority) == false);
+        REQUIRE(val == "c");
+        REQUIRE(priority == 3);
+        REQUIRE(ph.next(val, priority) == false);
+    }
+
+    SECTION("Matches prqueue on mixed operations") {
+        prheap<int> h;
+        prqueue<int> pq;
+        for (int i = 0; i < 2000; i++) {
+            int priority = (i * 7919) % 37;
+            h.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 3 == 0) {
+                REQUIRE(h.dequeue() == pq.dequeue());
+            }
+        }
+        REQUIRE(h.size() == pq.size());
+        REQUIRE(h.toString() == pq.toString());
+        while (pq.size() > 0) {
+            REQUIRE(h.peek() == pq.peek());
+            REQUIRE(h.dequeue() == pq.dequeue());
+        }
+    }
+}
+
+// counts the values alive right now, moved-from ones included
+struct LiveCounter {
+    static inline int live = 0;
+    int id;
+
+    LiveCounter(int id = 0) : id(id) {
+        live++;
+    }
+    LiveCounter(const LiveCounter& other) : id(other.id) {
+        live++;
+    }
+    LiveCounter& operator=(const LiveCounter& other) = default;
+    ~LiveCounter() {
+        live--;
+    }
+};
+
+// tests the radix heap engine with monotone priorities
+TEST_CASE("Test 15: Radix Heap Engine Test") {
+    prradix<int> pr;
+
+    SECTION("Empty radix heap") {
+        REQUIRE(pr.size() == 0);
+        REQUIRE(pr.peek() == 0);
+        REQUIRE(pr.dequeue() == 0);
+    }
+
+    SECTION("Negative and positive priorities before the first dequeue") {
+        pr.enqueue(1, 5);
+        pr.enqueue(2, -3);
+        pr.enqueue(3, 0);
+        pr.enqueue(4, -3);
+
+        REQUIRE(pr.toString() == "-3 value: 2\n-3 value: 4\n0 value: 3\n5 value: 1\n");
+        REQUIRE(pr.peek() == 2);
+        REQUIRE(pr.dequeue() == 2);
+        REQUIRE(pr.dequeue() == 4);
+        REQUIRE(pr.dequeue() == 3);
+        REQUIRE(pr.dequeue() == 1);
+        REQUIRE(pr.size() == 0);
+    }
+
+    SECTION("Monotone workload matches prqueue") {
+        prqueue<int> pq;
+        int lastDequeued = 0;
+        for (int i = 0; i < 3000; i++) {
+            int priority = lastDequeued + (i * 7919) % 101;
+            pr.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 2 == 0) {
+                REQUIRE(pr.peek() == pq.peek());
+                REQUIRE(pr.dequeue() == pq.dequeue());
+                pq.begin();
+                int val;
+                pq.next(val, lastDequeued);
+            }
+        }
+        REQUIRE(pr.size() == pq.size());
+        REQUIRE(pr.toString() == pq.toString());
+        while (pq.size() > 0) {
+            REQUIRE(pr.dequeue() == pq.dequeue());
+        }
+    }
+
+    SECTION("Begin and next walk in priority order") {
+        pr.enqueue(30, 3);
+        pr.enqueue(10, 1);
+        pr.enqueue(11, 1);
+
+        int val;
+        int priority;
+        pr.begin();
+        REQUIRE(pr.next(val, priority) == true);
+        REQUIRE(val == 10);
+        REQUIRE(pr.next(val, priority) == true);
+        REQUIRE(val == 11);
+        REQUIRE(pr.next(val, priority) == false);
+        REQUIRE(val == 30);
+        REQUIRE(priority == 3);
+    }
+
+    SECTION("Steady traffic at the last priority stays bounded") {
+        prradix<LiveCounter> zero;
+        zero.enqueue(LiveCounter(0), 5);
+        for (int i = 1; i <= 100000; i++) {
+            zero.enqueue(LiveCounter(i), 5);
+            REQUIRE(zero.dequeue().id == i - 1);
+        }
+        REQUIRE(zero.size() == 1);
+        REQUIRE(LiveCounter::live <= 64);
+        REQUIRE(zero.dequeue().id == 100000);
+    }
+}
+
+// tests the bucket queue engine and its calendar queue variant
+TEST_CASE("Test 16: Bucket Queue Engine Test") {
+
+    SECTION("Empty bucket queue") {
+        prbucket<int> pb;
+        REQUIRE(pb.size() == 0);
+        REQUIRE(pb.peek() == 0);
+        REQUIRE(pb.dequeue() == 0);
+        REQUIRE(pb.toString() == "");
+    }
+
+    SECTION("Priorities 0..255 with duplicates") {
+        prbucket<string> pb;
+        pb.enqueue("Ben", 255);
+        pb.enqueue("Jen", 0);
+        pb.enqueue("Sven", 64);
+        pb.enqueue("Gwen", 0);
+        pb.enqueue("Raven", 63);
+
+        REQUIRE(pb.size() == 5);
+        REQUIRE(pb.toString() == "0 value: Jen\n0 value: Gwen\n63 value: Raven\n64 value: Sven\n255 value: Ben\n");
+
+        string val;
+        int priority;
+        pb.begin();
+        REQUIRE(pb.next(val, priority) == true);
+        REQUIRE(val == "Jen");
+        REQUIRE(pb.next(val, priority) == true);
+        REQUIRE(val == "Gwen");
+        REQUIRE(pb.next(val, priority) == true);
+        REQUIRE(pb.next(val, priority) == true);
+        REQUIRE(pb.next(val, priority) == false);
+        REQUIRE(val == "Ben");
+        REQUIRE(priority == 255);
+
+        REQUIRE(pb.dequeue() == "Jen");
+        REQUIRE(pb.dequeue() == "Gwen");
+        REQUIRE(pb.peek() == "Raven");
+        pb.enqueue("Monty", 1);
+        REQUIRE(pb.peek() == "Monty");
+        REQUIRE(pb.size() == 4);
+    }
+
+    SECTION("Calendar queue matches prqueue") {
+        prbucket<int> cal(-5000, 5000, 37);
+        prqueue<int> pq;
+        for (int i = 0; i < 3000; i++) {
+            int priority = (i * 7919) % 10001 - 5000;
+            cal.enqueue(i, priority % 50);
+            pq.enqueue(i, priority % 50);
+            cal.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 3 == 0) {
+                REQUIRE(cal.peek() == pq.peek());
+                REQUIRE(cal.dequeue() == pq.dequeue());
+            }
+        }
+        REQUIRE(cal.size() == pq.size());
+        REQUIRE(cal.toString() == pq.toString());
+
+        cal.clear();
+        REQUIRE(cal.size() == 0);
+        REQUIRE(cal.toString() == "");
+    }
+
+    SECTION("Sparse calendar over a wide range") {
+        prbucket<string> cal(0, 1000000, 10);
+        cal.enqueue("Ben", 999999);
+        cal.enqueue("Jen", 15);
+        cal.enqueue("Sven", 12);
+        cal.enqueue("Gwen", 15);
+        cal.enqueue("Raven", 19);
+        REQUIRE(cal.toString() == "12 value: Sven\n15 value: Jen\n15 value: Gwen\n19 value: Raven\n999999 value: Ben\n");
+
+        // freed entries are reused by later enqueues
+        REQUIRE(cal.dequeue() == "Sven");
+        REQUIRE(cal.dequeue() == "Jen");
+        cal.enqueue("Monty", 10);
+        cal.enqueue("Lenny", 17);
+        REQUIRE(cal.toString() == "10 value: Monty\n15 value: Gwen\n17 value: Lenny\n19 value: Raven\n999999 value: Ben\n");
+        REQUIRE(cal.size() == 5);
+    }
+
+    SECTION("Out of range priorities are rejected") {
+        prbucket<int> pb(-10, 10);
+        REQUIRE_THROWS_AS(pb.enqueue(1, 11), out_of_range);
+        REQUIRE_THROWS_AS(pb.enqueue(1, -11), out_of_range);
+        REQUIRE_THROWS_AS(pb.enqueue(1, INT_MIN), out_of_range);
+        REQUIRE(pb.size() == 0);
+        pb.enqueue(1, 10);
+        REQUIRE(pb.size() == 1);
+        REQUIRE_THROWS_AS(prbucket<int>(5, 4), invalid_argument);
+        REQUIRE_THROWS_AS(prbucket<int>(0, 4, 0), invalid_argument);
+    }
+}
+
+// tests the pairing heap engine, meld and decreaseKey
+TEST_CASE("Test 17: Pairing Heap Engine Test") {
+    prpairing<int> pp;
+
+    SECTION("Empty pairing heap") {
+        REQUIRE(pp.size() == 0);
+        REQUIRE(pp.peek() == 0);
+        REQUIRE(pp.dequeue() == 0);
+    }
+
+    SECTION("Matches prqueue on mixed operations") {
+        prqueue<int> pq;
+        for (int i = 0; i < 3000; i++) {
+            int priority = (i * 7919) % 53;
+            pp.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 4 == 0) {
+                REQUIRE(pp.peek() == pq.peek());
+                REQUIRE(pp.dequeue() == pq.dequeue());
+            }
+        }
+        REQUIRE(pp.size() == pq.size());
+        REQUIRE(pp.toString() == pq.toString());
+        while (pq.size() > 0) {
+            REQUIRE(pp.dequeue() == pq.dequeue());
+        }
+    }
+
+    SECTION("Meld moves every element and keeps FIFO ties") {
+        prpairing<int> other;
+        pp.enqueue(1, 5);
+        other.enqueue(2, 5);
+        pp.enqueue(3, 2);
+        other.enqueue(4, 1);
+        other.enqueue(5, 5);
+
+        pp.meld(other);
+        REQUIRE(pp.size() == 5);
+        REQUIRE(other.size() == 0);
+        REQUIRE(other.dequeue() == 0);
+        REQUIRE(pp.toString() == "1 value: 4\n2 value: 3\n5 value: 1\n5 value: 2\n5 value: 5\n");
+
+        int val;
+        int priority;
+        pp.begin();
+        REQUIRE(pp.next(val, priority) == true);
+        REQUIRE(val == 4);
+        REQUIRE(priority == 1);
+    }
+
+    SECTION("Meld ends traversals of both queues") {
+        prpairing<int> other;
+        pp.enqueue(1, 1);
+        pp.enqueue(2, 2);
+        other.enqueue(3, 3);
+        other.enqueue(4, 4);
+
+        int val;
+        int priority;
+        pp.begin();
+        other.begin();
+        REQUIRE(other.next(val, priority) == true);
+        REQUIRE(val == 3);
+
+        pp.meld(other);
+        REQUIRE(other.next(val, priority) == false);
+        REQUIRE(pp.next(val, priority) == false);
+        REQUIRE(val == 3);
+
+        pp.begin();
+        for (int i = 1; i <= 3; i++) {
+            REQUIRE(pp.next(val, priority) == true);
+            REQUIRE(val == i);
+        }
+        REQUIRE(pp.next(val, priority) == false);
+        REQUIRE(val == 4);
+    }
+
+    SECTION("decreaseKey moves an element forward") {
+        pp.enqueue(10, 1);
+        prpairing<int>::handle h = pp.enqueue(20, 9);
+        pp.enqueue(30, 5);
+        prpairing<int>::handle h2 = pp.enqueue(40, 7);
+
+        pp.decreaseKey(h, 3);
+        REQUIRE(pp.dequeue() == 10);
+        REQUIRE(pp.peek() == 20);
+        pp.decreaseKey(h2, 0);
+        REQUIRE(pp.dequeue() == 40);
+        REQUIRE(pp.dequeue() == 20);
+        REQUIRE(pp.dequeue() == 30);
+        REQUIRE(pp.size() == 0);
+    }
+
+    SECTION("Copies are independent") {
+        pp.enqueue(1, 1);
+        pp.enqueue(2, 1);
+        prpairing<int> copied(pp);
+        prpairing<int> assigned;
+        assigned = pp;
+
+        REQUIRE(pp.dequeue() == 1);
+        REQUIRE(copied.toString() == "1 value: 1\n1 value: 2\n");
+        REQUIRE(assigned.dequeue() == 1);
+        REQUIRE(assigned.dequeue() == 2);
+        REQUIRE(copied.size() == 2);
+    }
+}
+
+// tests the skip list engine and its level 0 traversal
+TEST_CASE("Test 18: Skip List Engine Test") {
+    prskiplist<int> ps;
+
+    SECTION("Empty skip list") {
+        REQUIRE(ps.size() == 0);
+        REQUIRE(ps.peek() == 0);
+        REQUIRE(ps.dequeue() == 0);
+
+        int val;
+        int priority;
+        ps.begin();
+        REQUIRE(ps.next(val, priority) == false);
+    }
+
+    SECTION("Begin and next match prqueue") {
+        prqueue<int> pq;
+        for (int i = 0; i < 500; i++) {
+            ps.enqueue(i, (i * 31) % 17);
+            pq.enqueue(i, (i * 31) % 17);
+        }
+
+        int val1, val2;
+        int priority1, priority2;
+        ps.begin();
+        pq.begin();
+        bool more = true;
+        while (more) {
+            more = ps.next(val1, priority1);
+            REQUIRE(pq.next(val2, priority2) == more);
+            REQUIRE(val1 == val2);
+            REQUIRE(priority1 == priority2);
+        }
+        REQUIRE(ps.toString() == pq.toString());
+    }
+
+    SECTION("Sorted and reversed input dequeue in order") {
+        for (int i = 0; i < 1000; i++) {
+            ps.enqueue(i, i);
+            ps.enqueue(-i, -i);
+        }
+        for (int i = 999; i >= 0; i--) {
+            REQUIRE(ps.dequeue() == -i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            REQUIRE(ps.peek() == i);
+            REQUIRE(ps.dequeue() == i);
+        }
+        REQUIRE(ps.size() == 0);
+    }
+
+    SECTION("Copies are independent and compare equal") {
+        ps.enqueue(1, 2);
+        ps.enqueue(2, 1);
+        ps.enqueue(3, 2);
+        prskiplist<int> copied(ps);
+        prskiplist<int> assigned;
+        assigned = ps;
+
+        REQUIRE(copied == ps);
+        REQUIRE(assigned == ps);
+        REQUIRE(ps.dequeue() == 2);
+        REQUIRE((copied == ps) == false);
+        copied.enqueue(4, 2);
+        REQUIRE(copied.toString() == "1 value: 2\n2 value: 1\n2 value: 3\n2 value: 4\n");
+        REQUIRE(assigned.size() == 3);
+    }
+}
+
+// tests the B+tree engine across leaf and inner node splits
+TEST_CASE("Test 19: B+Tree Engine Test") {
+    prbtree<int> pb;
+
+    SECTION("Empty B+tree") {
+        REQUIRE(pb.size() == 0);
+        REQUIRE(pb.peek() == 0);
+        REQUIRE(pb.dequeue() == 0);
+        REQUIRE(pb.toString() == "");
+    }
+
+    SECTION("Sorted input splits into several levels") {
+        for (int i = 0; i < 20000; i++) {
+            pb.enqueue(i, i);
+        }
+        REQUIRE(pb.size() == 20000);
+        for (int i = 0; i < 20000; i++) {
+            REQUIRE(pb.peek() == i);
+            REQUIRE(pb.dequeue() == i);
+        }
+        REQUIRE(pb.size() == 0);
+
+        pb.enqueue(7, 7);
+        REQUIRE(pb.peek() == 7);
+    }
+
+    SECTION("Mixed priorities and duplicates match prqueue") {
+        prqueue<int> pq;
+        for (int i = 0; i < 5000; i++) {
+            int priority = (i * 7919) % 1009 - 500;
+            pb.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 3 == 0) {
+                REQUIRE(pb.dequeue() == pq.dequeue());
+            }
+        }
+        REQUIRE(pb.size() == pq.size());
+        REQUIRE(pb.toString() == pq.toString());
+
+        int val1, val2;
+        int priority1, priority2;
+        pb.begin();
+        pq.begin();
+        bool more = true;
+        while (more) {
+            more = pb.next(val1, priority1);
+            REQUIRE(pq.next(val2, priority2) == more);
+            REQUIRE(val1 == val2);
+            REQUIRE(priority1 == priority2);
+        }
+    }
+
+    SECTION("Copies are independent") {
+        for (int i = 0; i < 100; i++) {
+            pb.enqueue(i, 100 - i % 10);
+        }
+        prbtree<int> copied(pb);
+        pb.clear();
+        REQUIRE(pb.size() == 0);
+        REQUIRE(copied.size() == 100);
+        REQUIRE(copied.dequeue() == 9);
+        REQUIRE(copied.dequeue() == 19);
+    }
+
+    SECTION("Splits at every position of a full leaf") {
+
+        // a leaf holds 16 priorities, the 17th distinct one splits it
+        for (int pos = 0; pos <= 16; pos++) {
+            prbtree<int> full;
+            prqueue<int> pq;
+            for (int i = 1; i <= 16; i++) {
+                full.enqueue(i, 2 * i);
+                pq.enqueue(i, 2 * i);
+            }
+
+            // an equal priority only joins a FIFO, a new one splits
+            full.enqueue(-1, 2 * (pos % 16 + 1));
+            pq.enqueue(-1, 2 * (pos % 16 + 1));
+            full.enqueue(100 + pos, 2 * pos + 1);
+            pq.enqueue(100 + pos, 2 * pos + 1);
+            REQUIRE(full.toString() == pq.toString());
+
+            while (pq.size() > 0) {
+                REQUIRE(full.peek() == pq.peek());
+                REQUIRE(full.dequeue() == pq.dequeue());
+            }
+            REQUIRE(full.size() == 0);
+        }
+    }
+
+    SECTION("Inner splits from ascending, descending and zigzag input") {
+
+        // 16 * 17 priorities fill one inner node of full leaves, the sizes
+        // around it split the inner node and then the root
+        int sizes[] = {16, 17, 272, 273, 289, 4625};
+        for (int n : sizes) {
+            for (int order = 0; order < 3; order++) {
+                prbtree<int> tree;
+                prqueue<int> pq(true);
+                for (int i = 0; i < n; i++) {
+                    int priority = (order == 0) ? i
+                                 : (order == 1) ? n - i
+                                 : ((i % 2 == 0) ? i : n + n - i);
+                    tree.enqueue(i, priority);
+                    pq.enqueue(i, priority);
+                }
+                REQUIRE(tree.size() == n);
+                REQUIRE(tree.toString() == pq.toString());
+
+                // a new minimum after the left spine ran underfull
+                for (int i = 0; i < n / 2; i++) {
+                    REQUIRE(tree.dequeue() == pq.dequeue());
+                }
+                tree.enqueue(-1, INT_MIN);
+                pq.enqueue(-1, INT_MIN);
+                REQUIRE(tree.toString() == pq.toString());
+            }
+        }
+    }
+}
+
+// tests the hierarchical bitmap engine over the full int range
+TEST_CASE("Test 20: Hierarchical Bitmap Engine Test") {
+    prbitmap<int> pb;
+
+    SECTION("Empty bitmap queue") {
+        REQUIRE(pb.size() == 0);
+        REQUIRE(pb.peek() == 0);
+        REQUIRE(pb.dequeue() == 0);
+        REQUIRE(pb.toString() == "");
+    }
+
+    SECTION("Extreme priorities and duplicates") {
+        pb.enqueue(1, INT_MAX);
+        pb.enqueue(2, INT_MIN);
+        pb.enqueue(3, 0);
+        pb.enqueue(4, -1);
+        pb.enqueue(5, INT_MIN);
+        pb.enqueue(6, 64);
+
+        string expected = to_string(INT_MIN) + " value: 2\n" + to_string(INT_MIN) + " value: 5\n"
+                          "-1 value: 4\n0 value: 3\n64 value: 6\n" + to_string(INT_MAX) + " value: 1\n";
+        REQUIRE(pb.toString() == expected);
+
+        int val;
+        int priority;
+        pb.begin();
+        REQUIRE(pb.next(val, priority) == true);
+        REQUIRE(val == 2);
+        REQUIRE(priority == INT_MIN);
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(pb.next(val, priority) == true);
+        }
+        REQUIRE(pb.next(val, priority) == false);
+        REQUIRE(val == 1);
+        REQUIRE(priority == INT_MAX);
+
+        REQUIRE(pb.dequeue() == 2);
+        REQUIRE(pb.dequeue() == 5);
+        REQUIRE(pb.dequeue() == 4);
+        REQUIRE(pb.peek() == 3);
+        REQUIRE(pb.size() == 3);
+    }
+
+    SECTION("Scattered priorities match prqueue") {
+        prqueue<int> pq(true);
+        for (int i = 0; i < 5000; i++) {
+            int priority = (int)((unsigned)i * 2654435761u);
+            pb.enqueue(i, priority);
+            pq.enqueue(i, priority);
+            if (i % 2 == 0) {
+                pb.enqueue(-i, priority);
+                pq.enqueue(-i, priority);
+            }
+            if (i % 3 == 0) {
+                REQUIRE(pb.dequeue() == pq.dequeue());
+            }
+        }
+        REQUIRE(pb.toString() == pq.toString());
+
+        prbitmap<int> copied(pb);
+        while (pq.size() > 0) {
+            REQUIRE(pb.peek() == pq.peek());
+            REQUIRE(pb.dequeue() == pq.dequeue());
+        }
+        REQUIRE(pb.size() == 0);
+        REQUIRE(copied.size() > 0);
+    }
+
+    SECTION("Sparse and dense word transitions") {
+
+        // each level splits a key into 64-way words: 63/64 and 4095/4096
+        // are leaf and inner word boundaries, -1/0 flips the top bit
+        prqueue<int> pq;
+        int edges[] = {-1, 0, 63, 64, 127, 128, 4095, 4096, 262143, 262144,
+                       INT_MIN, INT_MIN + 63, INT_MIN + 64, INT_MAX - 64, INT_MAX};
+        for (int priority : edges) {
+            pb.enqueue(priority, priority);
+            pq.enqueue(priority, priority);
+        }
+        REQUIRE(pb.toString() == pq.toString());
+
+        int val1, val2;
+        int priority1, priority2;
+        pb.begin();
+        pq.begin();
+        bool more = true;
+        while (more) {
+            more = pb.next(val1, priority1);
+            REQUIRE(pq.next(val2, priority2) == more);
+            REQUIRE(priority1 == priority2);
+        }
+        while (pq.size() > 0) {
+            REQUIRE(pb.dequeue() == pq.dequeue());
+        }
+
+        // fills three leaf words completely, then empties the first one
+        for (int i = 0; i < 192; i++) {
+            pb.enqueue(i, i);
+        }
+        for (int i = 0; i < 64; i++) {
+            REQUIRE(pb.dequeue() == i);
+        }
+        REQUIRE(pb.peek() == 64);
+
+        // the emptied word comes back, and the walk crosses full words
+        pb.enqueue(-10, 10);
+        REQUIRE(pb.peek() == -10);
+        int val;
+        int priority;
+        int count = 0;
+        pb.begin();
+        while (pb.next(val, priority)) {
+            count++;
+        }
+        REQUIRE(count + 1 == 129);
+        REQUIRE(priority == 191);
+    }
+}
+
+// tests that NODE storage is recycled and released through the pool
+TEST_CASE("Test 21: Node Pool Test") {
+
+    SECTION("Steady churn keeps the queue consistent") {
+        prqueue<string> pq;
+        prheap<string> ph;
+        for (int i = 0; i < 100; i++) {
+            pq.enqueue(to_string(i), i % 10);
+            ph.enqueue(to_string(i), i % 10);
+        }
+        for (int i = 100; i < 20000; i++) {
+            REQUIRE(pq.dequeue() == ph.dequeue());
+            pq.enqueue(to_string(i), i % 10);
+            ph.enqueue(to_string(i), i % 10);
+        }
+        REQUIRE(pq.size() == 100);
+        REQUIRE(pq.toString() == ph.toString());
+
+        pq.clear();
+        REQUIRE(pq.size() == 0);
+        pq.enqueue("again", 1);
+        REQUIRE(pq.dequeue() == "again");
+    }
+
+    SECTION("Copy constructor makes an independent queue") {
+        prqueue<string> pq(true);
+        pq.enqueue("Ben", 1);
+        pq.enqueue("Jen", 2);
+        pq.enqueue("Sven", 2);
+
+        prqueue<string> copied(pq);
+        REQUIRE(copied == pq);
+        pq.clear();
+        REQUIRE(copied.size() == 3);
+        REQUIRE(copied.toString() == "1 value: Ben\n2 value: Jen\n2 value: Sven\n");
+        REQUIRE(copied.dequeue() == "Ben");
+        REQUIRE(copied.dequeue() == "Jen");
+    }
+}
+
+// counts the bytes handed out, to check that prqueue uses its allocator
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    long long* bytes;
+
+    explicit CountingAllocator(long long* bytes) : bytes(bytes) {}
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : bytes(other.bytes) {}
+
+    T* allocate(size_t n) {
+        *bytes += n * sizeof(T);
+        return allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        *bytes -= n * sizeof(T);
+        allocator<T>().deallocate(p, n);
+    }
+    bool operator==(const CountingAllocator& other) const {
+        return bytes == other.bytes;
+    }
+};
+
+// tests the Allocator template parameter and pmr support
+TEST_CASE("Test 22: Allocator Test") {
+
+    SECTION("Custom allocator supplies and gets back every slab") {
+        long long bytes = 0;
+        {
+            CountingAllocator<int> alloc(&bytes);
+            prqueue<int, CountingAllocator<int>> pq(true, alloc);
+            for (int i = 0; i < 1000; i++) {
+                pq.enqueue(i, i % 7);
+            }
+            REQUIRE(bytes > 0);
+            REQUIRE(pq.dequeue() == 0);
+
+            prqueue<int, CountingAllocator<int>> copied(pq);
+            REQUIRE(copied == pq);
+        }
+        REQUIRE(bytes == 0);
+    }
+
+    SECTION("pmr queue draws from a monotonic arena") {
+        char buffer[1 << 16];
+        pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+
+        pmr_prqueue<string> pq(&arena);
+        pq.enqueue("Ben", 2);
+        pq.enqueue("Jen", 1);
+        pq.enqueue("Sven", 2);
+        REQUIRE(pq.size() == 3);
+        REQUIRE(pq.get_allocator().resource() == &arena);
+        REQUIRE(pq.toString() == "1 value: Jen\n2 value: Ben\n2 value: Sven\n");
+        REQUIRE(pq.dequeue() == "Jen");
+
+        pmr_prqueue<int> balanced(true, pmr::polymorphic_allocator<int>(&arena));
+        for (int i = 0; i < 100; i++) {
+            balanced.enqueue(i, 100 - i);
+        }
+        REQUIRE(balanced.peek() == 99);
+    }
+
+    SECTION("Moves take over the pool without allocating") {
+        static_assert(is_nothrow_move_constructible_v<prqueue<string>>);
+        static_assert(is_nothrow_move_assignable_v<prqueue<string>>);
+        static_assert(is_nothrow_move_constructible_v<prsmall<string>>);
+
+        long long bytes = 0;
+        {
+            CountingAllocator<int> alloc(&bytes);
+            prqueue<int, CountingAllocator<int>> pq(true, alloc);
+            auto handle = pq.enqueue(-1, 5);
+            for (int i = 0; i < 1000; i++) {
+                pq.enqueue(i, i % 7);
+            }
+            long long before = bytes;
+
+            prqueue<int, CountingAllocator<int>> moved(std::move(pq));
+            REQUIRE(bytes == before);
+            REQUIRE(moved.size() == 1001);
+            REQUIRE(pq.size() == 0);
+            REQUIRE(pq.memory_usage() == 0);
+            moved.update_priority(handle, -1);
+            REQUIRE(moved.dequeue() == -1);
+
+            // the moved-from queue is empty and usable, and assigning over
+            // a full queue frees what it held
+            pq.enqueue(7, 7);
+            pq = std::move(moved);
+            REQUIRE(bytes == before);
+            REQUIRE(pq.size() == 1000);
+            REQUIRE(moved.size() == 0);
+            REQUIRE(pq.dequeue() == 0);
+        }
+        REQUIRE(bytes == 0);
+
+        // a vector of queues relocates them instead of copying them
+        vector<prqueue<string>> queues;
+        for (int i = 0; i < 100; i++) {
+            queues.emplace_back(true);
+            queues.back().enqueue(to_string(i), i);
+        }
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(queues[i].peek() == to_string(i));
+        }
+        swap(queues[0], queues[99]);
+        REQUIRE(queues[0].peek() == "99");
+
+        prsmall<string, 2> small;
+        small.enqueue("Ben", 2);
+        small.enqueue("Jen", 1);
+        prsmall<string, 2> smallMoved(std::move(small));
+        REQUIRE(small.size() == 0);
+        REQUIRE(smallMoved.toString() == "1 value: Jen\n2 value: Ben\n");
+        small.enqueue("Sven", 3);
+        small.enqueue("Gwen", 4);
+        small.enqueue("Raven", 0);
+        REQUIRE(small.isSpilled());
+        smallMoved = std::move(small);
+        REQUIRE(smallMoved.toString() == "0 value: Raven\n3 value: Sven\n4 value: Gwen\n");
+        REQUIRE(small.size() == 0);
+    }
+
+    SECTION("Move assignment across memory resources moves the elements") {
+        pmr::unsynchronized_pool_resource first, second;
+        pmr_prqueue<int> pq(true, pmr::polymorphic_allocator<int>(&first));
+        pmr_prqueue<int> other(false, pmr::polymorphic_allocator<int>(&second));
+        for (int i = 0; i < 50; i++) {
+            other.enqueue(i, i % 5);
+        }
+        string expected = other.toString();
+        pq = std::move(other);
+        REQUIRE(pq.toString() == expected);
+        REQUIRE(pq.get_allocator().resource() == &first);
+        REQUIRE(other.size() == 0);
+    }
+}
+
+// tests the index-based compact representation against prqueue
+TEST_CASE("Test 23: Compact Storage Test") {
+
+    SECTION("Empty compact queue") {
+        prcompact<int> pc;
+        REQUIRE(pc.size() == 0);
+        REQUIRE(pc.peek() == 0);
+        REQUIRE(pc.dequeue() == 0);
+    }
+
+    SECTION("Same order as prqueue") {
+        for (int mode = 0; mode < 2; mode++) {
+            prcompact<int> pc(mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (int i = 0; i < 3000; i++) {
+                int priority = (i * 7919) % 211;
+                pc.enqueue(i, priority);
+                pq.enqueue(i, priority);
+                if (i % 3 == 0) {
+                    REQUIRE(pc.peek() == pq.peek());
+                    REQUIRE(pc.dequeue() == pq.dequeue());
+                }
+            }
+            REQUIRE(pc.size() == pq.size());
+            REQUIRE(pc.toString() == pq.toString());
+
+            int val1, val2;
+            int priority1, priority2;
+            pc.begin();
+            pq.begin();
+            bool more = true;
+            while (more) {
+                more = pc.next(val1, priority1);
+                REQUIRE(pq.next(val2, priority2) == more);
+                REQUIRE(val1 == val2);
+                REQUIRE(priority1 == priority2);
+            }
+        }
+    }
+
+    SECTION("Operator= is an array copy") {
+        prcompact<string> pc(true);
+        prcompact<string> copied;
+        pc.enqueue("Ben", 2);
+        pc.enqueue("Jen", 1);
+        pc.enqueue("Sven", 2);
+        copied = pc;
+
+        REQUIRE(copied == pc);
+        REQUIRE(pc.dequeue() == "Jen");
+        REQUIRE((copied == pc) == false);
+        REQUIRE(copied.toString() == "1 value: Jen\n2 value: Ben\n2 value: Sven\n");
+
+        // freed slots are reused
+        pc.enqueue("Gwen", 0);
+        REQUIRE(pc.peek() == "Gwen");
+        REQUIRE(pc.size() == 3);
+    }
+
+    SECTION("Priorities that look like the null index") {
+
+        // -1 has the same bits as the NIL index, INT_MIN and INT_MAX are
+        // the ends of the range
+        prcompact<int> pc(true);
+        pc.enqueue(1, -1);
+        pc.enqueue(2, INT_MAX);
+        pc.enqueue(3, INT_MIN);
+        pc.enqueue(4, -1);
+        pc.enqueue(5, 0);
+        REQUIRE(pc.toString() == to_string(INT_MIN) + " value: 3\n-1 value: 1\n-1 value: 4\n"
+                                 "0 value: 5\n" + to_string(INT_MAX) + " value: 2\n");
+        REQUIRE(pc.dequeue() == 3);
+        REQUIRE(pc.dequeue() == 1);
+        REQUIRE(pc.dequeue() == 4);
+        REQUIRE(pc.dequeue() == 5);
+        REQUIRE(pc.dequeue() == 2);
+        REQUIRE(pc.size() == 0);
+    }
+
+    SECTION("Churn reuses node indices instead of growing") {
+        prcompact<int> pc(true);
+        for (int i = 0; i < 100; i++) {
+            pc.enqueue(i, i);
+        }
+        size_t settled = pc.memory_usage();
+
+        // 100000 distinct priorities pass through, 100 at a time, so the
+        // index space never grows past the first 100 slots
+        for (int i = 100; i < 100000; i++) {
+            pc.enqueue(i, i);
+            REQUIRE(pc.dequeue() == i - 100);
+        }
+        REQUIRE(pc.memory_usage() == settled);
+        REQUIRE(pc.size() == 100);
+    }
+}
+
+// tests the chunked FIFO of BLOCKs behind each compact priority
+TEST_CASE("Test 24: Priority Blocks Test") {
+
+    SECTION("Large burst at one priority stays FIFO") {
+        prcompact<int> pc;
+        for (int i = 0; i < 10000; i++) {
+            pc.enqueue(i, 5);
+        }
+        pc.enqueue(-1, 4);
+        pc.enqueue(-2, 6);
+        REQUIRE(pc.size() == 10002);
+        REQUIRE(pc.dequeue() == -1);
+        for (int i = 0; i < 10000; i++) {
+            REQUIRE(pc.peek() == i);
+            REQUIRE(pc.dequeue() == i);
+        }
+        REQUIRE(pc.dequeue() == -2);
+        REQUIRE(pc.size() == 0);
+    }
+
+    SECTION("Interleaved enqueue and dequeue on one level") {
+        prcompact<string> pc(true);
+        int in = 0;
+        int out = 0;
+        for (int round = 0; round < 50; round++) {
+            for (int i = 0; i < 70; i++) {
+                pc.enqueue(to_string(in++), 1);
+            }
+            for (int i = 0; i < 40; i++) {
+                REQUIRE(pc.dequeue() == to_string(out++));
+            }
+        }
+        REQUIRE(pc.size() == in - out);
+
+        // traversal walks the inline value and every block in order
+        string val;
+        int priority;
+        int expected = out;
+        pc.begin();
+        bool more = true;
+        while (more) {
+            more = pc.next(val, priority);
+            REQUIRE(val == to_string(expected++));
+            REQUIRE(priority == 1);
+        }
+        REQUIRE(expected == in);
+    }
+
+    SECTION("Equality compares the values at each priority") {
+        prcompact<int> a;
+        prcompact<int> b;
+        for (int i = 0; i < 300; i++) {
+            a.enqueue(i, i % 3);
+            b.enqueue(i, i % 3);
+        }
+        REQUIRE(a == b);
+        b.dequeue();
+        b.enqueue(0, 0);
+        REQUIRE((a == b) == false);
+    }
+
+    SECTION("FIFO block boundaries") {
+
+        // the first value sits inline and then 64 ints fill a block, so
+        // the counts around 1 + 64k end exactly at or just past a block
+        int counts[] = {1, 2, 64, 65, 66, 128, 129, 130, 193};
+        for (int n : counts) {
+            prcompact<int> pc;
+            for (int i = 0; i < n; i++) {
+                pc.enqueue(i, 3);
+            }
+            pc.enqueue(-1, 4);
+
+            int val;
+            int priority;
+            int expected = 0;
+            pc.begin();
+            while (pc.next(val, priority)) {
+                REQUIRE(val == expected++);
+            }
+            REQUIRE(expected == n);
+            REQUIRE(val == -1);
+
+            for (int i = 0; i < n; i++) {
+                REQUIRE(pc.peek() == i);
+                REQUIRE(pc.dequeue() == i);
+            }
+            REQUIRE(pc.dequeue() == -1);
+        }
+    }
+
+    SECTION("Emptied blocks are reused") {
+        prcompact<int> pc;
+
+        // the inline value plus one full block, drained to the boundary
+        for (int i = 0; i < 65; i++) {
+            pc.enqueue(i, 1);
+        }
+        pc.enqueue(-1, 2);
+
+        // the values straddle two blocks from the first round on, after
+        // that every block is recycled
+        size_t settled = 0;
+        for (int round = 0; round < 100; round++) {
+            for (int i = 0; i < 64; i++) {
+                REQUIRE(pc.dequeue() == round * 64 + i);
+            }
+            for (int i = 0; i < 64; i++) {
+                pc.enqueue(round * 64 + 65 + i, 1);
+            }
+            if (round == 0) {
+                settled = pc.memory_usage();
+            }
+        }
+        REQUIRE(pc.memory_usage() == settled);
+        REQUIRE(pc.size() == 66);
+        REQUIRE(pc.peek() == 6400);
+    }
+}
+
+// large payload for the hot/cold layout test
+struct BigPayload {
+    int id;
+    char bytes[300];
+
+    BigPayload(int id = 0) : id(id) {
+        for (int i = 0; i < 300; i++) {
+            bytes[i] = (char)(id + i);
+        }
+    }
+    bool operator!=(const BigPayload& other) const {
+        return id != other.id;
+    }
+};
+
+// tests that compact payloads live apart from the tree nodes
+TEST_CASE("Test 25: Hot/Cold Layout Test") {
+
+    SECTION("Tree nodes do not grow with the payload") {
+        static_assert(prcompact<char>::node_bytes() == prcompact<array<char, 256>>::node_bytes());
+        static_assert(prcompact<char>::node_bytes() == prcompact<BigPayload>::node_bytes());
+
+        // distinct priorities need no blocks, so each slot costs one NODE
+        // in the node array plus one T in the separate value array
+        prcompact<char> small;
+        prcompact<array<char, 256>> big;
+        for (int i = 0; i < 1000; i++) {
+            small.enqueue('a', (i * 37) % 1000);
+            big.enqueue(array<char, 256>{}, (i * 37) % 1000);
+        }
+        size_t slots = small.memory_usage() / (prcompact<char>::node_bytes() + 1);
+        REQUIRE(slots >= 1000);
+        REQUIRE(small.memory_usage() == slots * (prcompact<char>::node_bytes() + 1));
+        REQUIRE(big.memory_usage() == slots * (prcompact<char>::node_bytes() + 256));
+    }
+
+    SECTION("Large payloads keep priority order") {
+        for (int mode = 0; mode < 2; mode++) {
+            prcompact<BigPayload> pc(mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (int i = 0; i < 2000; i++) {
+                int priority = (i * 37) % 101;
+                pc.enqueue(BigPayload(i), priority);
+                pq.enqueue(i, priority);
+                if (i % 4 == 0) {
+                    REQUIRE(pc.peek().id == pq.peek());
+                    BigPayload out = pc.dequeue();
+                    REQUIRE(out.id == pq.dequeue());
+                    REQUIRE(out.bytes[299] == (char)(out.id + 299));
+                }
+            }
+            REQUIRE(pc.size() == pq.size());
+            while (pq.size() > 0) {
+                REQUIRE(pc.dequeue().id == pq.dequeue());
+            }
+            REQUIRE(pc.size() == 0);
+        }
+    }
+
+    SECTION("Reused slots get their new payload") {
+        prcompact<BigPayload> pc;
+        pc.enqueue(BigPayload(1), 1);
+        pc.enqueue(BigPayload(2), 2);
+        pc.dequeue();
+        pc.enqueue(BigPayload(3), 0);
+
+        prcompact<BigPayload> copied;
+        copied = pc;
+        REQUIRE(copied == pc);
+        REQUIRE(copied.dequeue().id == 3);
+        REQUIRE(copied.dequeue().id == 2);
+        REQUIRE(pc.peek().id == 3);
+    }
+}
+
+// counts how often values are copied and moved, for the move semantics
+// and relinking tests
+struct CopyCounter {
+    static inline int copies = 0;
+    static inline int moves = 0;
+    int id;
+
+    CopyCounter(int id = 0) : id(id) {}
+    CopyCounter(const CopyCounter& other) : id(other.id) {
+        copies++;
+    }
+    CopyCounter(CopyCounter&& other) noexcept : id(other.id) {
+        moves++;
+    }
+    CopyCounter& operator=(const CopyCounter& other) {
+        id = other.id;
+        copies++;
+        return *this;
+    }
+    CopyCounter& operator=(CopyCounter&& other) noexcept {
+        id = other.id;
+        moves++;
+        return *this;
+    }
+};
+
+// tests move-only values, emplace and the absence of copies in prqueue
+TEST_CASE("Test 26: Move Semantics Test") {
+
+    SECTION("Move-only values") {
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<unique_ptr<int>> pq(mode == 1);
+            for (int i = 0; i < 200; i++) {
+                pq.enqueue(make_unique<int>(i), (i * 13) % 17);
+            }
+            pq.emplace(-1, new int(-1));
+            REQUIRE(pq.size() == 201);
+            REQUIRE(*pq.dequeue() == -1);
+
+            prqueue<int> expected(mode == 1);
+            for (int i = 0; i < 200; i++) {
+                expected.enqueue(i, (i * 13) % 17);
+            }
+            while (expected.size() > 0) {
+                unique_ptr<int> out = pq.dequeue();
+                REQUIRE(*out == expected.dequeue());
+            }
+            REQUIRE(pq.dequeue() == nullptr);
+        }
+    }
+
+    SECTION("No copies on enqueue, emplace and dequeue") {
+        CopyCounter::copies = 0;
+        prqueue<CopyCounter> pq(true);
+        for (int i = 0; i < 100; i++) {
+            pq.enqueue(CopyCounter(i), i % 7);
+            pq.emplace(i % 5, i + 100);
+        }
+        while (pq.size() > 0) {
+            pq.dequeue();
+        }
+        REQUIRE(CopyCounter::copies == 0);
+
+        // lvalues are copied exactly once
+        CopyCounter value(5);
+        pq.enqueue(value, 1);
+        REQUIRE(CopyCounter::copies == 1);
+    }
+
+    SECTION("Emplace builds strings in place") {
+        prqueue<string> pq;
+        pq.emplace(2, 3, 'a');
+        pq.emplace(1, "Jen");
+        string name = "Ben";
+        pq.enqueue(name, 2);
+        REQUIRE(name == "Ben");
+        REQUIRE(pq.toString() == "1 value: Jen\n2 value: aaa\n2 value: Ben\n");
+    }
+}
+
+// tests that dequeue relinks nodes instead of moving values between them
+TEST_CASE("Test 27: Relinking Dequeue Test") {
+
+    SECTION("Dequeue moves only the returned value") {
+
+        // moves it takes to hand one value back, with nothing to relink
+        prqueue<CopyCounter> single;
+        single.emplace(0, 0);
+        CopyCounter::moves = 0;
+        single.dequeue();
+        int perDequeue = CopyCounter::moves;
+
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<CopyCounter> pq(mode == 1);
+
+            // every other minimum has a right subtree or a duplicate chain
+            for (int i = 0; i < 300; i++) {
+                pq.emplace((i * 31) % 50, i);
+            }
+
+            CopyCounter::copies = 0;
+            CopyCounter::moves = 0;
+            int count = pq.size();
+            while (pq.size() > 0) {
+                pq.dequeue();
+            }
+            REQUIRE(CopyCounter::copies == 0);
+            REQUIRE(CopyCounter::moves == count * perDequeue);
+        }
+    }
+
+    SECTION("Minimum with a right subtree is spliced out") {
+        prqueue<string> pq;
+        pq.enqueue("Root", 10);
+        pq.enqueue("Min", 1);
+        pq.enqueue("Right", 5);
+        pq.enqueue("RightLeft", 3);
+
+        // the right subtree of the minimum moves up under the root
+        REQUIRE(pq.dequeue() == "Min");
+        REQUIRE(pq.toString() == "3 value: RightLeft\n5 value: Right\n10 value: Root\n");
+
+        prqueue<string> expected;
+        expected.enqueue("Root", 10);
+        expected.enqueue("Right", 5);
+        expected.enqueue("RightLeft", 3);
+        REQUIRE(pq == expected);
+        REQUIRE(pq.peek() == "RightLeft");
+    }
+
+    SECTION("Duplicate takes over the tree position") {
+        prqueue<int> pq(true);
+        for (int i = 0; i < 5; i++) {
+            pq.enqueue(i, 2);
+        }
+        pq.enqueue(10, 1);
+        pq.enqueue(20, 3);
+        void *root = pq.getRoot();
+
+        REQUIRE(pq.dequeue() == 10);
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(pq.dequeue() == i);
+        }
+        REQUIRE(pq.getRoot() != nullptr);
+        REQUIRE(pq.dequeue() == 4);
+        REQUIRE(pq.dequeue() == 20);
+        REQUIRE(pq.getRoot() == nullptr);
+        REQUIRE(root != nullptr);
+    }
+}
+
+// tests reserve, shrink_to_fit and memory_usage of the node pool
+TEST_CASE("Test 28: Capacity Test") {
+
+    SECTION("Reserve takes allocation off the enqueue path") {
+        long long bytes = 0;
+        CountingAllocator<int> alloc(&bytes);
+        prqueue<int, CountingAllocator<int>> pq(true, alloc);
+        pq.enqueue(0, 0);
+        pq.reserve(5000);
+        long long reserved = bytes;
+        size_t usage = pq.memory_usage();
+        REQUIRE(usage >= (size_t)reserved);
+
+        for (int i = 1; i < 5000; i++) {
+            pq.enqueue(i, i % 10);
+        }
+        REQUIRE(bytes == reserved);
+        REQUIRE(pq.memory_usage() == usage);
+
+        // growing past the reservation allocates again
+        pq.enqueue(5000, 3);
+        REQUIRE(bytes > reserved);
+    }
+
+    SECTION("Shrink_to_fit returns empty slabs") {
+        long long bytes = 0;
+        CountingAllocator<int> alloc(&bytes);
+        prqueue<int, CountingAllocator<int>> pq(alloc);
+        for (int i = 0; i < 10000; i++) {
+            pq.enqueue(i, i % 100);
+        }
+        long long full = bytes;
+        size_t fullUsage = pq.memory_usage();
+
+        while (pq.size() > 10) {
+            pq.dequeue();
+        }
+        REQUIRE(bytes == full);
+        pq.shrink_to_fit();
+        REQUIRE(bytes < full);
+        REQUIRE(pq.memory_usage() < fullUsage);
+
+        // the remaining elements are untouched
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(pq.dequeue() == 9099 + 100 * i);
+        }
+        pq.shrink_to_fit();
+        REQUIRE(bytes == 0);
+
+        // the pool keeps working after shrinking
+        pq.enqueue(1, 1);
+        pq.enqueue(2, 1);
+        REQUIRE(pq.dequeue() == 1);
+        REQUIRE(pq.dequeue() == 2);
+    }
+
+    SECTION("Memory usage counts duplicate chains") {
+        prqueue<int> single;
+        prqueue<int> dups;
+        for (int i = 0; i < 2000; i++) {
+            single.enqueue(i, 0);
+            dups.enqueue(i, i);
+        }
+        REQUIRE(single.memory_usage() == dups.memory_usage());
+        REQUIRE(single.memory_usage() >= 2000 * sizeof(int));
+
+        prqueue<int> empty;
+        REQUIRE(empty.memory_usage() == 0);
+    }
+}
+
+// object with an embedded hook for the intrusive queue test
+struct Job : prhook {
+    int id;
+    Job(int id = 0) : id(id) {}
+};
+
+ostream& operator<<(ostream& os, const Job& job) {
+    return os << "job" << job.id;
+}
+
+// tests the intrusive queue over caller-owned objects
+TEST_CASE("Test 29: Intrusive Queue Test") {
+
+    SECTION("Empty intrusive queue") {
+        printrusive<Job> pi;
+        REQUIRE(pi.size() == 0);
+        REQUIRE(pi.peek() == nullptr);
+        REQUIRE(pi.dequeue() == nullptr);
+    }
+
+    SECTION("Same order as prqueue, objects are never copied") {
+        for (int mode = 0; mode < 2; mode++) {
+            vector<Job> jobs;
+            for (int i = 0; i < 3000; i++) {
+                jobs.emplace_back(i);
+            }
+
+            printrusive<Job> pi(mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (int i = 0; i < 3000; i++) {
+                int priority = (i * 7919) % 211;
+                pi.enqueue(jobs[i], priority);
+                pq.enqueue(i, priority);
+                if (i % 3 == 0) {
+                    REQUIRE(pi.peek()->id == pq.peek());
+                    Job *out = pi.dequeue();
+                    REQUIRE(out == &jobs[out->id]);
+                    REQUIRE(out->id == pq.dequeue());
+                }
+            }
+            REQUIRE(pi.size() == pq.size());
+
+            Job *job;
+            int val, priority1, priority2;
+            pi.begin();
+            pq.begin();
+            bool more = true;
+            while (more) {
+                more = pi.next(job, priority1);
+                REQUIRE(pq.next(val, priority2) == more);
+                REQUIRE(job->id == val);
+                REQUIRE(priority1 == priority2);
+            }
+
+            while (pq.size() > 0) {
+                REQUIRE(pi.dequeue()->id == pq.dequeue());
+            }
+            REQUIRE(pi.size() == 0);
+        }
+    }
+
+    SECTION("Dequeued objects can be queued again") {
+        Job a(1), b(2), c(3);
+        printrusive<Job> pi(true);
+        pi.enqueue(a, 5);
+        pi.enqueue(b, 5);
+        pi.enqueue(c, 1);
+        REQUIRE(pi.toString() == "1 value: job3\n5 value: job1\n5 value: job2\n");
+
+        REQUIRE(pi.dequeue() == &c);
+        pi.enqueue(c, 9);
+        REQUIRE(pi.dequeue() == &a);
+        REQUIRE(pi.dequeue() == &b);
+        REQUIRE(pi.dequeue() == &c);
+
+        pi.enqueue(a, 0);
+        pi.clear();
+        REQUIRE(pi.size() == 0);
+        pi.enqueue(a, 4);
+        REQUIRE(pi.peek() == &a);
+    }
+}
+
+// tests the small-buffer queue inline and after spilling
+TEST_CASE("Test 30: Small Buffer Test") {
+
+    SECTION("Short queues stay inline") {
+        prsmall<string, 4> ps;
+        REQUIRE(ps.peek() == "");
+        REQUIRE(ps.dequeue() == "");
+        ps.enqueue("Ben", 2);
+        ps.enqueue("Jen", 1);
+        ps.enqueue("Sven", 2);
+        ps.enqueue("Gwen", 0);
+        REQUIRE(ps.isSpilled() == false);
+        REQUIRE(ps.memory_usage() == 0);
+        REQUIRE(ps.size() == 4);
+        REQUIRE(ps.peek() == "Gwen");
+        REQUIRE(ps.toString() == "0 value: Gwen\n1 value: Jen\n2 value: Ben\n2 value: Sven\n");
+
+        string value;
+        int priority;
+        ps.begin();
+        REQUIRE(ps.next(value, priority) == true);
+        REQUIRE(value == "Gwen");
+        REQUIRE(ps.next(value, priority) == true);
+        REQUIRE(ps.next(value, priority) == true);
+        REQUIRE(ps.next(value, priority) == false);
+        REQUIRE(value == "Sven");
+        REQUIRE(priority == 2);
+    }
+
+    SECTION("Spills past N and comes back") {
+        for (int mode = 0; mode < 2; mode++) {
+            prsmall<int, 8> ps(mode == 1);
+            prqueue<int> pq;
+            for (int round = 0; round < 20; round++) {
+                int n = (round % 2 == 0) ? 6 : 40;
+                for (int i = 0; i < n; i++) {
+                    int priority = (i * 5) % 3;
+                    ps.enqueue(round * 100 + i, priority);
+                    pq.enqueue(round * 100 + i, priority);
+                }
+                REQUIRE(ps.isSpilled() == (n > 8));
+                REQUIRE(ps.toString() == pq.toString());
+                while (pq.size() > 0) {
+                    REQUIRE(ps.peek() == pq.peek());
+                    REQUIRE(ps.dequeue() == pq.dequeue());
+                }
+                REQUIRE(ps.size() == 0);
+                REQUIRE(ps.isSpilled() == false);
+            }
+        }
+    }
+
+    SECTION("Copies keep their own elements") {
+        prsmall<int, 2> ps;
+        ps.enqueue(1, 1);
+        prsmall<int, 2> copied = ps;
+        ps.enqueue(2, 2);
+        ps.enqueue(3, 3);
+        REQUIRE(ps.isSpilled() == true);
+        REQUIRE(copied.size() == 1);
+        REQUIRE(copied.dequeue() == 1);
+        REQUIRE(ps.dequeue() == 1);
+        REQUIRE(ps.size() == 2);
+    }
+}
+
+// tests bulk loading through the range constructor and assign
+TEST_CASE("Test 31: Bulk Construction Test") {
+
+    SECTION("Range constructor matches enqueue") {
+        vector<pair<int, int>> items;
+        for (int i = 0; i < 5000; i++) {
+            items.push_back({i, (i * 7919) % 613});
+        }
+
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> built(items.begin(), items.end(), mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (auto &item : items) {
+                pq.enqueue(item.first, item.second);
+            }
+            REQUIRE(built.size() == 5000);
+            REQUIRE(built.toString() == pq.toString());
+
+            // the built tree keeps working with enqueue and dequeue
+            for (int i = 0; i < 3000; i++) {
+                built.enqueue(-i, i % 700);
+                pq.enqueue(-i, i % 700);
+                REQUIRE(built.dequeue() == pq.dequeue());
+            }
+            while (pq.size() > 0) {
+                REQUIRE(built.peek() == pq.peek());
+                REQUIRE(built.dequeue() == pq.dequeue());
+            }
+            REQUIRE(built.size() == 0);
+        }
+    }
+
+    SECTION("Sorted snapshot and duplicates") {
+        vector<pair<string, int>> items;
+        for (int i = 0; i < 100000; i++) {
+            items.push_back({to_string(i), i / 4});
+        }
+
+        prqueue<string> pq;
+        pq.assign(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+        REQUIRE(pq.size() == 100000);
+        REQUIRE(items[5].first == "");
+        for (int i = 0; i < 100000; i++) {
+            REQUIRE(pq.dequeue() == to_string(i));
+        }
+    }
+
+    SECTION("Assign replaces the contents") {
+        prqueue<string> pq;
+        pq.enqueue("Old", 0);
+
+        vector<pair<string, int>> items = {{"Ben", 2}, {"Jen", 1}, {"Sven", 2}, {"Gwen", 1}};
+        pq.assign(items.begin(), items.end());
+        REQUIRE(pq.toString() == "1 value: Jen\n1 value: Gwen\n2 value: Ben\n2 value: Sven\n");
+
+        prqueue<string> copied = pq;
+        REQUIRE(copied == pq);
+
+        vector<pair<string, int>> none;
+        pq.assign(none.begin(), none.end());
+        REQUIRE(pq.size() == 0);
+        REQUIRE(pq.dequeue() == "");
+    }
+}
+
+// tests batch removal with dequeue_n and drain
+TEST_CASE("Test 32: Batch Dequeue Test") {
+
+    SECTION("Dequeue_n matches repeated dequeue") {
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> batched(mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (int i = 0; i < 5000; i++) {
+                batched.enqueue(i, (i * 7919) % 307);
+                pq.enqueue(i, (i * 7919) % 307);
+            }
+
+            vector<pair<int, int>> out;
+            while (pq.size() > 0) {
+                out.clear();
+                batched.dequeue_n(64, back_inserter(out));
+                REQUIRE(out.size() == (size_t)min(64, pq.size()));
+                for (auto &item : out) {
+                    int priority = (item.first < 0) ? 400 : (item.first * 7919) % 307;
+                    REQUIRE(item.second == priority);
+                    REQUIRE(item.first == pq.dequeue());
+                }
+                REQUIRE(batched.size() == pq.size());
+
+                // keeps the remaining tree usable between batches
+                if (pq.size() > 1000) {
+                    batched.enqueue(-1, 400);
+                    pq.enqueue(-1, 400);
+                }
+            }
+            REQUIRE(batched.size() == 0);
+            out.clear();
+            batched.dequeue_n(10, back_inserter(out));
+            REQUIRE(out.empty());
+        }
+    }
+
+    SECTION("Drain moves everything out") {
+        prqueue<unique_ptr<int>> pq(true);
+        for (int i = 0; i < 100; i++) {
+            pq.enqueue(make_unique<int>(i), i % 4);
+        }
+
+        vector<pair<unique_ptr<int>, int>> out(100);
+        auto end = pq.drain(out.begin());
+        REQUIRE(end == out.end());
+        REQUIRE(pq.size() == 0);
+        REQUIRE(pq.dequeue() == nullptr);
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(out[i].second == i / 25);
+            REQUIRE(*out[i].first == (i % 25) * 4 + i / 25);
+        }
+    }
+}
+
+// tests batch insertion with enqueue_batch
+TEST_CASE("Test 33: Batch Enqueue Test") {
+
+    SECTION("Batches match one-by-one enqueue") {
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> batched(mode == 1);
+            prqueue<int> pq(mode == 1);
+            for (int round = 0; round < 30; round++) {
+                vector<pair<int, int>> batch;
+                for (int i = 0; i < 500; i++) {
+                    int priority;
+                    if (round % 3 == 0) {
+                        priority = round * 10 + i / 7;          // sorted
+                    }
+                    else if (round % 3 == 1) {
+                        priority = (i % 50) * 3 + round % 5;    // several sorted runs
+                    }
+                    else {
+                        priority = (i * 7919 + round) % 1009;   // scattered
+                    }
+                    batch.push_back({round * 1000 + i, priority});
+                    pq.enqueue(round * 1000 + i, priority);
+                }
+                batched.enqueue_batch(batch);
+                REQUIRE(batched.size() == pq.size());
+
+                for (int i = 0; i < 200; i++) {
+                    REQUIRE(batched.dequeue() == pq.dequeue());
+                }
+            }
+            REQUIRE(batched.toString() == pq.toString());
+            while (pq.size() > 0) {
+                REQUIRE(batched.dequeue() == pq.dequeue());
+            }
+        }
+    }
+
+    SECTION("Values are moved out of the batch") {
+        vector<pair<string, int>> batch = {{"Ben", 2}, {"Jen", 1}, {"Sven", 2}, {"Gwen", 1}};
+        prqueue<string> pq;
+        pq.enqueue("Ken", 2);
+        pq.enqueue_batch(batch);
+        REQUIRE(pq.size() == 5);
+        REQUIRE(pq.toString() == "1 value: Jen\n1 value: Gwen\n2 value: Ken\n2 value: Ben\n2 value: Sven\n");
+        REQUIRE(batch[0].first == "");
+
+        vector<pair<string, int>> empty;
+        pq.enqueue_batch(empty);
+        REQUIRE(pq.size() == 5);
+    }
+
+    SECTION("Sorted batches into a sorted chain") {
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> pq(mode == 1);
+
+            // in the default mode sorted enqueues leave a chain 2000 deep
+            for (int i = 0; i < 2000; i++) {
+                pq.enqueue(i, 2 * i);
+            }
+
+            // one batch above everything, one between the chain's
+            // priorities and one on them
+            vector<pair<int, int>> above, between, same;
+            for (int i = 0; i < 100000; i++) {
+                above.push_back({4000 + i, 4000 + i});
+            }
+            for (int i = 0; i < 2000; i++) {
+                between.push_back({2 * i + 1, 2 * i + 1});
+                same.push_back({-i - 1, 2 * i});
+            }
+            pq.enqueue_batch(above);
+            pq.enqueue_batch(between);
+            pq.enqueue_batch(same);
+            REQUIRE(pq.size() == 106000);
+            REQUIRE(pq.height() < 64);
+            if (mode == 1) {
+                REQUIRE(pq.isRedBlack());
+            }
+
+            for (int p = 0; p < 4000; p++) {
+                if (p % 2 == 0) {
+                    REQUIRE(pq.dequeue() == p / 2);
+                    REQUIRE(pq.dequeue() == -p / 2 - 1);
+                }
+                else {
+                    REQUIRE(pq.dequeue() == p);
+                }
+            }
+            for (int p = 4000; p < 104000; p++) {
+                REQUIRE(pq.dequeue() == p);
+            }
+            REQUIRE(pq.size() == 0);
+        }
+    }
+}
+
+// tests handles from enqueue with update_priority and erase
+TEST_CASE("Test 34: Handles Test") {
+
+    SECTION("Erase from the tree and from duplicate lists") {
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> pq(mode == 1);
+            vector<prqueue<int>::handle> handles;
+            for (int i = 0; i < 1000; i++) {
+                handles.push_back(pq.enqueue(i, i % 37));
+            }
+
+            // cancels every third element, heads and chain members alike
+            for (int i = 0; i < 1000; i += 3) {
+                pq.erase(handles[i]);
+            }
+            REQUIRE(pq.size() == 666);
+
+            prqueue<int> expected(mode == 1);
+            for (int i = 0; i < 1000; i++) {
+                if (i % 3 != 0) {
+                    expected.enqueue(i, i % 37);
+                }
+            }
+            REQUIRE(pq.toString() == expected.toString());
+            while (expected.size() > 0) {
+                REQUIRE(pq.peek() == expected.peek());
+                REQUIRE(pq.dequeue() == expected.dequeue());
+            }
+            REQUIRE(pq.size() == 0);
+        }
+    }
+
+    SECTION("Update priority moves to the back of the new level") {
+        prqueue<string> pq(true);
+        auto ben = pq.enqueue("Ben", 2);
+        auto jen = pq.enqueue("Jen", 1);
+        pq.enqueue("Sven", 2);
+        auto gwen = pq.enqueue("Gwen", 3);
+
+        pq.update_priority(gwen, 1);
+        pq.update_priority(ben, 5);
+        pq.update_priority(jen, 1);
+        REQUIRE(pq.toString() == "1 value: Jen\n1 value: Gwen\n2 value: Sven\n5 value: Ben\n");
+
+        pq.update_priority(jen, 4);
+        REQUIRE(pq.peek() == "Gwen");
+        pq.erase(ben);
+        REQUIRE(pq.toString() == "1 value: Gwen\n2 value: Sven\n4 value: Jen\n");
+        REQUIRE(pq.size() == 3);
+
+        // handles stay valid across other removals
+        REQUIRE(pq.dequeue() == "Gwen");
+        pq.update_priority(jen, 0);
+        REQUIRE(pq.dequeue() == "Jen");
+        REQUIRE(pq.dequeue() == "Sven");
+        REQUIRE(pq.size() == 0);
+    }
+
+    SECTION("Reprioritizing a third of the jobs") {
+        prqueue<int> pq(true);
+        prqueue<int> expected(true);
+        vector<prqueue<int>::handle> handles;
+        for (int i = 0; i < 3000; i++) {
+            handles.push_back(pq.enqueue(i, (i * 7919) % 500));
+        }
+        for (int i = 0; i < 3000; i++) {
+            if (i % 3 == 1) {
+                pq.update_priority(handles[i], 1000 + i % 10);
+            }
+        }
+        for (int i = 0; i < 3000; i++) {
+            if (i % 3 != 1) {
+                expected.enqueue(i, (i * 7919) % 500);
+            }
+        }
+        for (int i = 0; i < 3000; i++) {
+            if (i % 3 == 1) {
+                expected.enqueue(i, 1000 + i % 10);
+            }
+        }
+        while (expected.size() > 0) {
+            REQUIRE(pq.dequeue() == expected.dequeue());
+        }
+    }
+}
+
+// tests merging two prqueues by relinking their nodes
+TEST_CASE("Test 35: Merge Test") {
+
+    SECTION("Merge matches enqueueing the other queue afterwards") {
+        for (int mode = 0; mode < 4; mode++) {
+            bool mineBalanced = (mode & 1) != 0;
+            bool theirsBalanced = (mode & 2) != 0;
+            prqueue<int> pq(mineBalanced);
+            prqueue<int> other(theirsBalanced);
+            prqueue<int> expected(mineBalanced);
+            for (int i = 0; i < 2000; i++) {
+                pq.enqueue(i, (i * 7919) % 300);
+                expected.enqueue(i, (i * 7919) % 300);
+            }
+            for (int i = 0; i < 500; i++) {
+                other.enqueue(10000 + i, (i * 31) % 600 - 100);
+            }
+            for (int i = 0; i < 500; i++) {
+                expected.enqueue(10000 + i, (i * 31) % 600 - 100);
+            }
+
+            pq.merge(std::move(other));
+            REQUIRE(pq.size() == 2500);
+            REQUIRE(other.size() == 0);
+            REQUIRE(other.toString() == "");
+            REQUIRE(pq.toString() == expected.toString());
+            while (expected.size() > 0) {
+                REQUIRE(pq.peek() == expected.peek());
+                REQUIRE(pq.dequeue() == expected.dequeue());
+            }
+            REQUIRE(pq.size() == 0);
+
+            // the emptied queue can be filled again
+            other.enqueue(1, 1);
+            other.enqueue(0, 0);
+            REQUIRE(other.dequeue() == 0);
+            REQUIRE(other.dequeue() == 1);
+        }
+    }
+
+    SECTION("Merge into a queue built from sorted input") {
+
+        // sorted enqueues leave the default mode tree a chain 5000 deep
+        for (int mode = 0; mode < 2; mode++) {
+            prqueue<int> pq;
+            prqueue<int> other(mode == 1);
+            for (int i = 0; i < 5000; i++) {
+                pq.enqueue(i, i);
+            }
+            REQUIRE(pq.height() == 5000);
+            other.enqueue(-1, 2500);
+            other.enqueue(-2, -1);
+            pq.merge(std::move(other));
+            REQUIRE(pq.size() == 5002);
+            REQUIRE(pq.dequeue() == -2);
+            for (int i = 0; i <= 2500; i++) {
+                REQUIRE(pq.dequeue() == i);
+            }
+            REQUIRE(pq.dequeue() == -1);
+            REQUIRE(pq.dequeue() == 2501);
+        }
+
+        // and a sorted chain merged into a small queue
+        prqueue<int> pq;
+        prqueue<int> other;
+        for (int i = 0; i < 5000; i++) {
+            other.enqueue(i, 5000 - i);
+        }
+        pq.enqueue(-1, 0);
+        pq.merge(std::move(other));
+        REQUIRE(pq.size() == 5001);
+        REQUIRE(pq.dequeue() == -1);
+        REQUIRE(pq.dequeue() == 4999);
+    }
+
+    SECTION("Only a too deep default mode queue is relinked") {
+
+        // a perfect tree of 15 with a tail of 3 sorted enqueues is 7 deep,
+        // within 2 log2(n + 1) of 18 elements, so merge leaves it as it is
+        prqueue<int> pq;
+        int perfect[] = {8, 4, 12, 2, 6, 10, 14, 1, 3, 5, 7, 9, 11, 13, 15, 16, 17, 18};
+        for (int priority : perfect) {
+            pq.enqueue(priority, priority);
+        }
+        REQUIRE(pq.height() == 7);
+        prqueue<int> other;
+        other.enqueue(100, 100);
+        pq.merge(std::move(other));
+        REQUIRE(pq.height() == 8);
+
+        // a chain of 100 sorted enqueues is relinked before the union
+        prqueue<int> chain;
+        for (int i = 0; i < 100; i++) {
+            chain.enqueue(i, i);
+        }
+        REQUIRE(chain.height() == 100);
+        other.enqueue(-1, 50);
+        chain.merge(std::move(other));
+        REQUIRE(chain.height() <= 8);
+        REQUIRE(chain.size() == 101);
+        for (int i = 0; i <= 50; i++) {
+            REQUIRE(chain.dequeue() == i);
+        }
+        REQUIRE(chain.dequeue() == -1);
+    }
+
+    SECTION("Merging into or from an empty queue") {
+        prqueue<string> pq(true);
+        prqueue<string> other(true);
+        pq.merge(std::move(other));
+        REQUIRE(pq.size() == 0);
+
+        other.enqueue("Ben", 2);
+        other.enqueue("Jen", 1);
+        pq.merge(std::move(other));
+        REQUIRE(pq.toString() == "1 value: Jen\n2 value: Ben\n");
+        REQUIRE(other.size() == 0);
+
+        pq.merge(std::move(other));
+        other.enqueue("Sven", 2);
+        other.merge(std::move(pq));
+        REQUIRE(other.toString() == "1 value: Jen\n2 value: Sven\n2 value: Ben\n");
+        REQUIRE(pq.size() == 0);
+    }
+
+    SECTION("Handles into the other queue keep working") {
+        prqueue<int> pq(true);
+        prqueue<int> other(true);
+        for (int i = 0; i < 100; i++) {
+            pq.enqueue(i, i);
+        }
+        auto handle = other.enqueue(-1, 50);
+        other.enqueue(-2, 200);
+        pq.merge(std::move(other));
+        pq.update_priority(handle, -5);
+        REQUIRE(pq.dequeue() == -1);
+        REQUIRE(pq.dequeue() == 0);
+        REQUIRE(pq.size() == 100);
+    }
+
+    SECTION("Merge steals nodes without allocating") {
+        long long bytes = 0;
+        {
+            CountingAllocator<int> alloc(&bytes);
+            prqueue<int, CountingAllocator<int>> pq(true, alloc);
+            prqueue<int, CountingAllocator<int>> other(true, alloc);
+            for (int i = 0; i < 1000; i++) {
+                pq.enqueue(i, i % 50);
+                other.enqueue(i, i % 70);
+            }
+            long long before = bytes;
+            pq.merge(std::move(other));
+            REQUIRE(bytes == before);
+            REQUIRE(pq.size() == 2000);
+            REQUIRE(other.memory_usage() == 0);
+
+            // the adopted nodes go back to the merged pool
+            while (pq.size() > 0) {
+                pq.dequeue();
+            }
+            for (int i = 0; i < 2000; i++) {
+                pq.enqueue(i, i);
+            }
+            REQUIRE(bytes == before);
+        }
+        REQUIRE(bytes == 0);
+    }
+
+    SECTION("Queues on different memory resources are moved over") {
+        pmr::unsynchronized_pool_resource first, second;
+        pmr_prqueue<int> pq(true, pmr::polymorphic_allocator<int>(&first));
+        pmr_prqueue<int> other(false, pmr::polymorphic_allocator<int>(&second));
+        prqueue<int> expected(true);
+        for (int i = 0; i < 300; i++) {
+            pq.enqueue(i, i % 10);
+            expected.enqueue(i, i % 10);
+        }
+        for (int i = 0; i < 300; i++) {
+            other.enqueue(-i, i % 20);
+            expected.enqueue(-i, i % 20);
+        }
+
+        pq.merge(std::move(other));
+        REQUIRE(pq.size() == 600);
+        REQUIRE(other.size() == 0);
+        REQUIRE(pq.toString() == expected.toString());
+    }
+}